@@ -14,6 +14,8 @@
 
 #include <memory>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <set>
 
 #include "Tree.hpp"
@@ -39,6 +41,131 @@ struct AMTSourceData {
 	std::vector<FilterAudioFrame> audioFrames;
 };
 
+// GOPƂ̃V[N
+// TS͌Ƀt[XgĒԃt@CƈꏏɕۑĂA
+// AMTSource̓fR[hĕV[Nʒu߂
+// iɓt@CJAMTSource͎sȂŃV[Nłj
+struct GopIndexEntry {
+	int32_t keyFrame; // GOP擪t[i\t[ԍj
+	int32_t seekKey; // GOP̃t[fR[h邽߂ɃV[NL[t[
+	int64_t fileOffset; // seekKeỹt@Cʒu
+	int32_t verified; // seekKeyfR[hł邱ƂmFς݂
+	int32_t reserved;
+};
+
+class GopIndex {
+public:
+	enum {
+		MAGIC = 0x58444E49, // "INDX"
+		VERSION = 1
+	};
+
+	GopIndex() : seekDistance(10), dirty(false) { }
+
+	void build(const std::vector<FilterSourceFrame>& frames) {
+		entries.clear();
+		for (int i = 0; i < (int)frames.size(); ++i) {
+			if (frames[i].keyFrame == i) {
+				GopIndexEntry entry = GopIndexEntry();
+				entry.keyFrame = i;
+				entry.seekKey = i;
+				entry.fileOffset = frames[i].fileOffset;
+				entries.push_back(entry);
+			}
+		}
+		seekDistance = 10;
+		dirty = false;
+	}
+
+	// ǂ߂Ȃfalse
+	bool load(const tstring& path, const std::vector<FilterSourceFrame>& frames) {
+		build(frames);
+		try {
+			File file(path, _T("rb"));
+			if (file.readValue<int32_t>() != MAGIC ||
+				file.readValue<int32_t>() != VERSION ||
+				file.readValue<int32_t>() != (int32_t)entries.size())
+			{
+				return false;
+			}
+			int dist = file.readValue<int32_t>();
+			std::vector<GopIndexEntry> loaded(entries.size());
+			for (int i = 0; i < (int)loaded.size(); ++i) {
+				loaded[i] = file.readValue<GopIndexEntry>();
+				if (loaded[i].keyFrame != entries[i].keyFrame ||
+					loaded[i].seekKey < 0 || loaded[i].seekKey > loaded[i].keyFrame)
+				{
+					return false;
+				}
+			}
+			entries.swap(loaded);
+			seekDistance = std::max(seekDistance, dist);
+			return true;
+		}
+		catch (const Exception&) {
+			// ̃vZXݒꍇȂǂ͍蒼̂g
+			build(frames);
+			return false;
+		}
+	}
+
+	void save(const tstring& path) const {
+		File file(path, _T("wb"));
+		file.writeValue<int32_t>(MAGIC);
+		file.writeValue<int32_t>(VERSION);
+		file.writeValue<int32_t>((int32_t)entries.size());
+		file.writeValue<int32_t>(seekDistance);
+		for (const auto& entry : entries) {
+			file.writeValue(entry);
+		}
+	}
+
+	// L[t[keyFrameGOP
+	int find(int keyFrame) const {
+		auto it = std::lower_bound(entries.begin(), entries.end(), keyFrame,
+			[](const GopIndexEntry& e, int key) { return e.keyFrame < key; });
+		if (it == entries.end() || it->keyFrame != keyFrame) {
+			THROW(InvalidOperationException, "GOPCfbNXɂȂL[t[ł");
+		}
+		return int(it - entries.begin());
+	}
+
+	const GopIndexEntry& get(int gop) const {
+		return entries[gop];
+	}
+
+	// seekKeyfR[hł
+	void setSeekKey(int gop, int seekKey, int64_t fileOffset) {
+		GopIndexEntry& entry = entries[gop];
+		if (entry.seekKey != seekKey || entry.verified == 0) {
+			entry.seekKey = seekKey;
+			entry.fileOffset = fileOffset;
+			entry.verified = 1;
+			dirty = true;
+		}
+	}
+
+	int getSeekDistance() const {
+		return seekDistance;
+	}
+
+	void setSeekDistance(int dist) {
+		if (dist > seekDistance) {
+			seekDistance = dist;
+			dirty = true;
+		}
+	}
+
+	bool isDirty() const {
+		return dirty;
+	}
+
+private:
+	std::vector<GopIndexEntry> entries;
+	int seekDistance;
+	bool dirty;
+};
+
 class AMTSource : public IClip, AMTObject
 {
 	const std::vector<FilterSourceFrame>& frames;
@@ -50,21 +177,67 @@ class AMTSource : public IClip, AMTObject
 
 	bool outputQP; // QPe[uo͂邩
 
-	InputContext inputCtx;
-	CodecContext codecCtx;
+	// fR[_
+	// ꍇ͂ꂼʂGOPɃfR[h
+	struct Decoder {
+		InputContext inputCtx;
+		CodecContext codecCtx;
+
+#if ENABLE_FFMPEG_FILTER
+		FilterGraph filterGraph;
+		AVFilterContext* bufferSrcCtx;
+		AVFilterContext* bufferSinkCtx;
+#endif
+
+		AVStream *videoStream;
+
+		// OnFrameDecodedŒOɃfR[hꂽt[
+		// ܂fR[hĂȂꍇ-1
+		int lastDecodeFrame;
+
+		// codecCtxOɃfR[ht[ԍ
+		// ܂fR[hĂȂꍇnullptr
+		std::unique_ptr<Frame> prevFrame;
+
+		// Onon B QPe[u
+		PVideoFrame nonBQPTable;
+
+		// goal̃t[io͂ꂽێČĂяoɕԂj
+		// LbV͑̃Xbh̃fR[hŒǂo\̂
+		PVideoFrame goalFrame;
+
+		// ȉpoolMutexŕی
+		bool busy;
+		int goal; // fR[h̃t[
+		int position; // gplastDecodeFrame
+		int64_t lastUsed;
 
+		Decoder(const tstring& srcpath)
+			: inputCtx(srcpath)
 #if ENABLE_FFMPEG_FILTER
-	FilterGraph filterGraph;
-	AVFilterContext* bufferSrcCtx;
-	AVFilterContext* bufferSinkCtx;
+			, bufferSrcCtx()
+			, bufferSinkCtx()
 #endif
+			, videoStream()
+			, lastDecodeFrame(-1)
+			, busy(false)
+			, goal(-1)
+			, position(-1)
+			, lastUsed(0)
+		{ }
+	};
 
-	AVStream *videoStream;
+	std::vector<std::unique_ptr<Decoder>> decoders;
+	std::mutex poolMutex;
+	std::condition_variable poolCond;
+	int64_t useCounter;
+	int numDecoders;
 
 	std::unique_ptr<AMTSourceData> storage;
 
 	struct CacheFrame {
 		PVideoFrame data;
+		int64_t bytes;
 		TreeNode<int, CacheFrame*> treeNode;
 		ListNode<CacheFrame*> listNode;
 	};
@@ -72,27 +245,34 @@ class AMTSource : public IClip, AMTObject
 	Tree<int, CacheFrame*> frameCache;
 	List<CacheFrame*> recentAccessed;
 
+	// gILbVm[hinew/deleteJԂȂ悤ɍėpj
+	std::vector<CacheFrame*> freeNodes;
+	// LbVꂽt[őQƂĂȂ́ĩt[̃obt@ɍėpj
+	std::vector<PVideoFrame> framePool;
+
+	int64_t cacheBudget; // oCg 0Ȃ疇݂̂Ő
+	int64_t cacheBytes;
+	int64_t poolBytes;
+	int64_t peakBytes;
+	int64_t numHit;
+	int64_t numMiss;
+	int64_t numEvict;
+
 	// fR[hłȂt[̒u惊Xg
 	std::map<int, int> failedMap;
 
 	VideoInfo vi;
 
+	// LbVAfailedMapAgopIndexی
 	std::mutex mutex;
+	std::mutex audioMutex;
 
-	File waveFile;
-
-	int seekDistance;
-
-	// OnFrameDecodedŒOɃfR[hꂽt[
-	// ܂fR[hĂȂꍇ-1
-	int lastDecodeFrame;
+	WaveFrameReader waveReader;
 
-	// codecCtxOɃfR[ht[ԍ
-	// ܂fR[hĂȂꍇnullptr
-	std::unique_ptr<Frame> prevFrame;
+	std::atomic<int> seekDistance;
 
-	// Onon B QPe[u
-	PVideoFrame nonBQPTable;
+	GopIndex gopIndex;
+	tstring gopIndexPath;
 
 	AVCodec* getHWAccelCodec(AVCodecID vcodecId)
 	{
@@ -125,8 +305,8 @@ class AMTSource : public IClip, AMTObject
 		return avcodec_find_decoder(vcodecId);
 	}
 
-	void MakeCodecContext(IScriptEnvironment* env) {
-		AVCodecID vcodecId = videoStream->codecpar->codec_id;
+	void MakeCodecContext(Decoder& dec, IScriptEnvironment* env) {
+		AVCodecID vcodecId = dec.videoStream->codecpar->codec_id;
 		AVCodec *pCodec = getHWAccelCodec(vcodecId);
 		if (pCodec == NULL) {
 			ctx.warn("w肳ꂽfR[_gpłȂ߃ftHgfR[_g܂");
@@ -135,57 +315,58 @@ class AMTSource : public IClip, AMTObject
 		if (pCodec == NULL) {
 			env->ThrowError("Could not find decoder ...");
 		}
-		codecCtx.Set(pCodec);
-		if (avcodec_parameters_to_context(codecCtx(), videoStream->codecpar) != 0) {
+		dec.codecCtx.Set(pCodec);
+		if (avcodec_parameters_to_context(dec.codecCtx(), dec.videoStream->codecpar) != 0) {
 			env->ThrowError("avcodec_parameters_to_context failed");
 		}
-		codecCtx()->pkt_timebase = videoStream->time_base;
-		codecCtx()->thread_count = GetFFmpegThreads(GetProcessorCount());
+		dec.codecCtx()->pkt_timebase = dec.videoStream->time_base;
+		// fR[_ꍇCPU𕪂
+		dec.codecCtx()->thread_count = GetFFmpegThreads(GetProcessorCount() / numDecoders);
 
 		// export_mvs for codecview
 		//AVDictionary *opts = NULL;
 		//av_dict_set(&opts, "flags2", "+export_mvs", 0);
 
-		if (avcodec_open2(codecCtx(), pCodec, NULL) != 0) {
+		if (avcodec_open2(dec.codecCtx(), pCodec, NULL) != 0) {
 			env->ThrowError("avcodec_open2 failed");
 		}
 	}
 
 #if ENABLE_FFMPEG_FILTER
-	void MakeFilterGraph(IScriptEnvironment* env) {
+	void MakeFilterGraph(Decoder& dec, IScriptEnvironment* env) {
 		char args[512];
 		const AVFilter *buffersrc = avfilter_get_by_name("buffer");
 		const AVFilter *buffersink = avfilter_get_by_name("buffersink");
 		FilterInOut outputs;
 		FilterInOut inputs;
-		AVRational time_base = videoStream->time_base;
+		AVRational time_base = dec.videoStream->time_base;
 
-		filterGraph.Create();
-		bufferSrcCtx = nullptr;
-		bufferSinkCtx = nullptr;
+		dec.filterGraph.Create();
+		dec.bufferSrcCtx = nullptr;
+		dec.bufferSinkCtx = nullptr;
 
-		filterGraph()->nb_threads = 4;
+		dec.filterGraph()->nb_threads = 4;
 
 		/* buffer video source: the decoded frames from the decoder will be inserted here. */
 		snprintf(args, sizeof(args),
 			"video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=%d/%d",
-			codecCtx()->width, codecCtx()->height, codecCtx()->pix_fmt,
+			dec.codecCtx()->width, dec.codecCtx()->height, dec.codecCtx()->pix_fmt,
 			time_base.num, time_base.den,
-			codecCtx()->sample_aspect_ratio.num, codecCtx()->sample_aspect_ratio.den);
+			dec.codecCtx()->sample_aspect_ratio.num, dec.codecCtx()->sample_aspect_ratio.den);
 
-		if (avfilter_graph_create_filter(&bufferSrcCtx, buffersrc, "in",
-			args, NULL, filterGraph()) < 0) {
+		if (avfilter_graph_create_filter(&dec.bufferSrcCtx, buffersrc, "in",
+			args, NULL, dec.filterGraph()) < 0) {
 			env->ThrowError("avfilter_graph_create_filter failed (Cannot create buffer source)");
 		}
 
 		/* buffer video sink: to terminate the filter chain. */
-		if (avfilter_graph_create_filter(&bufferSinkCtx, buffersink, "out",
-			NULL, NULL, filterGraph()) < 0) {
+		if (avfilter_graph_create_filter(&dec.bufferSinkCtx, buffersink, "out",
+			NULL, NULL, dec.filterGraph()) < 0) {
 			env->ThrowError("avfilter_graph_create_filter failed (Cannot create buffer sink)");
 		}
 
-		if (av_opt_set_bin(bufferSinkCtx, "pix_fmts",
-			(uint8_t*)&codecCtx()->pix_fmt, sizeof(codecCtx()->pix_fmt),
+		if (av_opt_set_bin(dec.bufferSinkCtx, "pix_fmts",
+			(uint8_t*)&dec.codecCtx()->pix_fmt, sizeof(dec.codecCtx()->pix_fmt),
 			AV_OPT_SEARCH_CHILDREN) < 0) {
 			env->ThrowError("av_opt_set_bin failed (cannot set output pixel format)");
 		}
@@ -202,7 +383,7 @@ class AMTSource : public IClip, AMTObject
 		* default.
 		*/
 		outputs()->name = av_strdup("in");
-		outputs()->filter_ctx = bufferSrcCtx;
+		outputs()->filter_ctx = dec.bufferSrcCtx;
 		outputs()->pad_idx = 0;
 		outputs()->next = NULL;
 
@@ -213,16 +394,16 @@ class AMTSource : public IClip, AMTObject
 		* default.
 		*/
 		inputs()->name = av_strdup("out");
-		inputs()->filter_ctx = bufferSinkCtx;
+		inputs()->filter_ctx = dec.bufferSinkCtx;
 		inputs()->pad_idx = 0;
 		inputs()->next = NULL;
 
-		if (avfilter_graph_parse_ptr(filterGraph(), filterdesc.c_str(),
+		if (avfilter_graph_parse_ptr(dec.filterGraph(), filterdesc.c_str(),
 			&inputs(), &outputs(), NULL) < 0) {
 			env->ThrowError("avfilter_graph_parse_ptr failed");
 		}
 
-		if (avfilter_graph_config(filterGraph(), NULL) < 0) {
+		if (avfilter_graph_config(dec.filterGraph(), NULL) < 0) {
 			env->ThrowError("avfilter_graph_config failed");
 		}
 	}
@@ -258,15 +439,15 @@ class AMTSource : public IClip, AMTObject
 		}
 	}
 
-	void UpdateVideoInfo(IScriptEnvironment* env)
+	void UpdateVideoInfo(Decoder& dec, IScriptEnvironment* env)
 	{
 		// rbg[x͎擾ĂȂ̂ffmpeg擾
-		vi.pixel_type = toAVSFormat(codecCtx()->pix_fmt, env);
+		vi.pixel_type = toAVSFormat(dec.codecCtx()->pix_fmt, env);
 
 #if ENABLE_FFMPEG_FILTER
-		if (bufferSinkCtx) {
+		if (dec.bufferSinkCtx) {
 			// tB^΃tB^̏o͂ɍXV
-			const AVFilterLink* outlink = bufferSinkCtx->inputs[0];
+			const AVFilterLink* outlink = dec.bufferSinkCtx->inputs[0];
 			vi.pixel_type = toAVSFormat((AVPixelFormat)outlink->format, env);
 
 			if (outlink->w != vi.width ||
@@ -277,13 +458,13 @@ class AMTSource : public IClip, AMTObject
 #endif
 	}
 
-	void ResetDecoder(IScriptEnvironment* env) {
-		lastDecodeFrame = -1;
-		prevFrame = nullptr;
-		MakeCodecContext(env);
+	void ResetDecoder(Decoder& dec, IScriptEnvironment* env) {
+		dec.lastDecodeFrame = -1;
+		dec.prevFrame = nullptr;
+		MakeCodecContext(dec, env);
 #if ENABLE_FFMPEG_FILTER
 		if (filterdesc.size()) {
-			MakeFilterGraph(env);
+			MakeFilterGraph(dec, env);
 		}
 #endif
 	}
@@ -354,8 +535,8 @@ class AMTSource : public IClip, AMTObject
 		}
 	}
 
-	PVideoFrame MakeFrame(AVFrame* top, AVFrame* bottom, IScriptEnvironment* env) {
-		PVideoFrame ret = env->NewVideoFrame(vi);
+	PVideoFrame MakeFrame(Decoder& dec, AVFrame* top, AVFrame* bottom, IScriptEnvironment* env) {
+		PVideoFrame ret = NewFrame(env);
 		const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)(top->format));
 
 		if (desc->comp[0].depth > 8) {
@@ -387,10 +568,10 @@ class AMTSource : public IClip, AMTObject
 				env->BitBlt(qpframe->GetWritePtr(), qpframe->GetPitch(), 
 					(const BYTE*)qp_table, qpvi.width, qpvi.width, qpvi.height);
 				if (top->pict_type != AV_PICTURE_TYPE_B) {
-					nonBQPTable = qpframe;
+					dec.nonBQPTable = qpframe;
 				}
 				ret->SetProperty("QP_Table", qpframe);
-				ret->SetProperty("QP_Table_Non_B", nonBQPTable);
+				ret->SetProperty("QP_Table_Non_B", dec.nonBQPTable);
 				ret->SetProperty("QP_Stride", qp_stride ? qpframe->GetPitch() : 0);
 				ret->SetProperty("QP_ScaleType", qp_scale_type);
 
@@ -407,21 +588,85 @@ class AMTSource : public IClip, AMTObject
 		return ret;
 	}
 
+	static int64_t FrameBytes(const PVideoFrame& frame) {
+		int64_t bytes = (int64_t)frame->GetPitch(PLANAR_Y) * frame->GetHeight(PLANAR_Y);
+		bytes += (int64_t)frame->GetPitch(PLANAR_U) * frame->GetHeight(PLANAR_U);
+		bytes += (int64_t)frame->GetPitch(PLANAR_V) * frame->GetHeight(PLANAR_V);
+		return bytes;
+	}
+
+	// o̓t[mہiv[ɂ΍ėpj
+	PVideoFrame NewFrame(IScriptEnvironment* env) {
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			if (framePool.size() > 0) {
+				PVideoFrame frame = framePool.back();
+				framePool.pop_back();
+				poolBytes -= FrameBytes(frame);
+				// Õt[̕t͏Ă
+				frame->DeleteProperty("QP_Table");
+				frame->DeleteProperty("QP_Table_Non_B");
+				frame->DeleteProperty("QP_Stride");
+				frame->DeleteProperty("QP_ScaleType");
+				frame->DeleteProperty("DC_Table");
+				return frame;
+			}
+		}
+		return env->NewVideoFrame(vi);
+	}
+
+	// mutexbNČĂԂ
+	void EvictFrame() {
+		CacheFrame* pdel = recentAccessed.back().value;
+		frameCache.erase(frameCache.it(&pdel->treeNode));
+		recentAccessed.erase(recentAccessed.it(&pdel->listNode));
+		cacheBytes -= pdel->bytes;
+		++numEvict;
+		// ǂQƂĂȂ΃obt@ėp
+		if (pdel->data->IsWritable() && (int)framePool.size() < numDecoders * 2) {
+			poolBytes += pdel->bytes;
+			framePool.push_back(pdel->data);
+		}
+		pdel->data = nullptr;
+		freeNodes.push_back(pdel);
+	}
+
+	// mutexbNČĂԂ
 	void PutFrame(int n, const PVideoFrame& frame) {
-		CacheFrame* pcache = new CacheFrame();
+		auto it = frameCache.find(n);
+		if (it != frameCache.end()) {
+			// ̃fR[_łɃfR[h
+			UpdateAccessed(it->value);
+			return;
+		}
+		CacheFrame* pcache;
+		if (freeNodes.size() > 0) {
+			pcache = freeNodes.back();
+			freeNodes.pop_back();
+		}
+		else {
+			pcache = new CacheFrame();
+		}
 		pcache->data = frame;
+		pcache->bytes = FrameBytes(frame);
 		pcache->treeNode.key = n;
 		pcache->treeNode.value = pcache;
 		pcache->listNode.value = pcache;
 		frameCache.insert(&pcache->treeNode);
 		recentAccessed.push_front(&pcache->listNode);
-
-		if ((int)recentAccessed.size() > seekDistance * 3 / 2) {
-			// LbVꂽ폜
-			CacheFrame* pdel = recentAccessed.back().value;
-			frameCache.erase(frameCache.it(&pdel->treeNode));
-			recentAccessed.erase(recentAccessed.it(&pdel->listNode));
-			delete pdel;
+		cacheBytes += pcache->bytes;
+		peakBytes = std::max(peakBytes, cacheBytes + poolBytes);
+
+		// LbVꂽ폜
+		// eʂŐꍇAÕt[ɃfR[hȂčςނ悤ɊefR[_͎c
+		// ifR[h̃t[̓fR[_goalFrameŕێĂ̂ŁAŏĂĂяoɂ͕ԂB
+		//   QƂcĂobt@framePoolɉ񂳂Ȃ̂ŏ㏑Ȃj
+		const int maxFrames = seekDistance * 3 / 2 * numDecoders;
+		const int minFrames = numDecoders * 8;
+		while ((int)recentAccessed.size() > maxFrames ||
+			(cacheBudget > 0 && cacheBytes > cacheBudget && (int)recentAccessed.size() > minFrames))
+		{
+			EvictFrame();
 		}
 	}
 
@@ -442,17 +687,17 @@ class AMTSource : public IClip, AMTObject
 	}
 
 #if ENABLE_FFMPEG_FILTER
-	void InputFrameFilter(Frame* frame, bool enableOut, IScriptEnvironment* env)
+	void InputFrameFilter(Decoder& dec, Frame* frame, bool enableOut, IScriptEnvironment* env)
 	{
 		/* push the decoded frame into the filtergraph */
-		if (av_buffersrc_add_frame_flags(bufferSrcCtx, frame ? (*frame)() : nullptr, 0) < 0) {
+		if (av_buffersrc_add_frame_flags(dec.bufferSrcCtx, frame ? (*frame)() : nullptr, 0) < 0) {
 			env->ThrowError("av_buffersrc_add_frame_flags failed (Error while feeding the filtergraph)");
 		}
 
 		/* pull filtered frames from the filtergraph */
 		while (1) {
 			Frame filtered;
-			int ret = av_buffersink_get_frame(bufferSinkCtx, filtered());
+			int ret = av_buffersink_get_frame(dec.bufferSinkCtx, filtered());
 			if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
 				// Ɠ͂Kv or t[Ȃ
 				break;
@@ -461,25 +706,25 @@ class AMTSource : public IClip, AMTObject
 				env->ThrowError("av_buffersink_get_frame failed");
 			}
 			if (enableOut) {
-				OnFrameOutput(filtered, env);
+				OnFrameOutput(dec, filtered, env);
 			}
 		}
 	}
 
-	void OnFrameDecoded(Frame& frame, IScriptEnvironment* env)
+	void OnFrameDecoded(Decoder& dec, Frame& frame, IScriptEnvironment* env)
 	{
-		if (bufferSrcCtx) {
+		if (dec.bufferSrcCtx) {
 			// tB^
 			//frame()->pts = frame()->best_effort_timestamp;
-			InputFrameFilter(&frame, true, env);
+			InputFrameFilter(dec, &frame, true, env);
 		}
 		else {
-			OnFrameOutput(frame, env);
+			OnFrameOutput(dec, frame, env);
 		}
 	}
 #endif
 
-	void OnFrameOutput(Frame& frame, IScriptEnvironment* env)
+	void OnFrameOutput(Decoder& dec, Frame& frame, IScriptEnvironment* env)
 	{
 		// ffmpegpts wrap̎dȂ̂ŉ33bit݂̂
 		//i26Ԉȏ゠铮悾Əd\͂邪j
@@ -504,9 +749,9 @@ class AMTSource : public IClip, AMTObject
 			tailDiff = pts - frames.back().framePTS;
 			// Ỏ\̂ŁA
 			if (headDiff == 0 || headDiff > tailDiff) {
-				lastDecodeFrame = vi.num_frames;
+				dec.lastDecodeFrame = vi.num_frames;
 			}
-			prevFrame = nullptr; // AłȂȂꍇnullZbg
+			dec.prevFrame = nullptr; // AłȂȂꍇnullZbg
 			return;
 		}
 
@@ -514,23 +759,25 @@ class AMTSource : public IClip, AMTObject
 			// vt[Ȃ
 			ctx.incrementCounter(AMT_ERR_UNKNOWN_PTS);
 			ctx.warnF("Unknown PTS frame %lld", pts);
-			prevFrame = nullptr; // AłȂȂꍇnullZbg
+			dec.prevFrame = nullptr; // AłȂȂꍇnullZbg
 			return;
 		}
 
 		int frameIndex = int(it - frames.begin());
-		auto cacheit = frameCache.find(frameIndex);
 
+		// t[쐬͏d̂ŃbN̊Oōs
 		if (it->halfDelay) {
 			// fBCKp
-			if (cacheit != frameCache.end()) {
+			if (TouchCache(frameIndex, GoalFramePtr(dec, frameIndex))) {
 				// łɃLbVɂ
-				UpdateAccessed(cacheit->value);
-				lastDecodeFrame = frameIndex;
+				dec.lastDecodeFrame = frameIndex;
 			}
-			else if (prevFrame != nullptr) {
-				PutFrame(frameIndex, MakeFrame((*prevFrame)(), frame(), env));
-				lastDecodeFrame = frameIndex;
+			else if (dec.prevFrame != nullptr) {
+				PVideoFrame made = MakeFrame(dec, (*dec.prevFrame)(), frame(), env);
+				SetGoalFrame(dec, frameIndex, made);
+				std::lock_guard<std::mutex> guard(mutex);
+				PutFrame(frameIndex, made);
+				dec.lastDecodeFrame = frameIndex;
 			}
 			else {
 				// Õt[Ȃ̂Ńt[Ȃ
@@ -539,37 +786,62 @@ class AMTSource : public IClip, AMTObject
 			// ̃t[t[QƂĂ炻o
 			auto next = it + 1;
 			if (next != frames.end() && next->framePTS == it->framePTS) {
-				auto cachenext = frameCache.find(frameIndex + 1);
-				if (cachenext != frameCache.end()) {
-					// łɃLbVɂ
-					UpdateAccessed(cachenext->value);
-				}
-				else {
-					PutFrame(frameIndex + 1, MakeFrame(frame(), frame(), env));
+				if (!TouchCache(frameIndex + 1, GoalFramePtr(dec, frameIndex + 1))) {
+					PVideoFrame made = MakeFrame(dec, frame(), frame(), env);
+					SetGoalFrame(dec, frameIndex + 1, made);
+					std::lock_guard<std::mutex> guard(mutex);
+					PutFrame(frameIndex + 1, made);
 				}
-				lastDecodeFrame = frameIndex + 1;
+				dec.lastDecodeFrame = frameIndex + 1;
 			}
 		}
 		else {
 			// ̂܂
-			if (cacheit != frameCache.end()) {
-				// łɃLbVɂ
-				UpdateAccessed(cacheit->value);
-			}
-			else {
-				PutFrame(frameIndex, MakeFrame(frame(), frame(), env));
+			if (!TouchCache(frameIndex, GoalFramePtr(dec, frameIndex))) {
+				PVideoFrame made = MakeFrame(dec, frame(), frame(), env);
+				SetGoalFrame(dec, frameIndex, made);
+				std::lock_guard<std::mutex> guard(mutex);
+				PutFrame(frameIndex, made);
 			}
-			lastDecodeFrame = frameIndex;
+			dec.lastDecodeFrame = frameIndex;
 		}
 
-		prevFrame = std::unique_ptr<Frame>(new Frame(frame));
+		dec.prevFrame = std::unique_ptr<Frame>(new Frame(frame));
 	}
 
+	// mutexbNČĂԂ
 	void UpdateAccessed(CacheFrame* frame) {
 		recentAccessed.erase(recentAccessed.it(&frame->listNode));
 		recentAccessed.push_front(&frame->listNode);
 	}
 
+	// LbVɂ΃ANZXXVtrue
+	// outnullptrłȂ΃t[Ԃ
+	bool TouchCache(int n, PVideoFrame* out = nullptr) {
+		std::lock_guard<std::mutex> guard(mutex);
+		auto it = frameCache.find(n);
+		if (it != frameCache.end()) {
+			UpdateAccessed(it->value);
+			if (out != nullptr) {
+				*out = it->value->data;
+			}
+			return true;
+		}
+		return false;
+	}
+
+	// nfR[_goalȂgoalFrameԂ
+	PVideoFrame* GoalFramePtr(Decoder& dec, int n) {
+		return (n == dec.goal) ? &dec.goalFrame : nullptr;
+	}
+
+	void SetGoalFrame(Decoder& dec, int n, const PVideoFrame& frame) {
+		if (n == dec.goal) {
+			dec.goalFrame = frame;
+		}
+	}
+
+	// mutexbNČĂԂ
 	PVideoFrame ForceGetFrame(int n, IScriptEnvironment* env) {
 		if (frameCache.size() == 0) {
 			return env->NewVideoFrame(vi);
@@ -582,7 +854,7 @@ class AMTSource : public IClip, AMTObject
 		return lb->value->data;
 	}
 
-	void DecodeLoop(int goal, IScriptEnvironment* env) {
+	void DecodeLoop(Decoder& dec, int goal, IScriptEnvironment* env) {
 		Frame frame;
 		AVPacket packet = AVPacket();
 
@@ -602,7 +874,7 @@ class AMTSource : public IClip, AMTObject
 		int64_t keyFramePTS = -1;
 		auto isFrameReady = [&]() {
 			// V[Nŏ̃t[łȂȂOK
-			if (lastDecodeFrame != -1) return true;
+			if (dec.lastDecodeFrame != -1) return true;
 			// L[t[ȂOK
 			if (frame()->key_frame) return true;
 			// ^CX^vL[t[̂̂ȂL[t[Ɣf
@@ -611,40 +883,41 @@ class AMTSource : public IClip, AMTObject
 			return false;
 		};
 
-		while (av_read_frame(inputCtx(), &packet) == 0) {
-			if (packet.stream_index == videoStream->index) {
+		while (av_read_frame(dec.inputCtx(), &packet) == 0) {
+			if (packet.stream_index == dec.videoStream->index) {
 				if ((packet.flags & AV_PKT_FLAG_KEY) && keyFramePTS == -1) {
 					// ŏ̃L[t[PTSoĂ
 					keyFramePTS = packet.pts;
 				}
-				if (avcodec_send_packet(codecCtx(), &packet) != 0) {
+				if (avcodec_send_packet(dec.codecCtx(), &packet) != 0) {
 					ctx.incrementCounter(AMT_ERR_DECODE_PACKET_FAILED);
 					ctx.warn("avcodec_send_packet failed");
 				}
-				while (avcodec_receive_frame(codecCtx(), frame()) == 0) {
+				while (avcodec_receive_frame(dec.codecCtx(), frame()) == 0) {
 					// ŏ̓L[t[܂ŃXLbv
 					if (isFrameReady()) {
 #if ENABLE_FFMPEG_FILTER
-						OnFrameDecoded(frame, env);
+						OnFrameDecoded(dec, frame, env);
 #else
-						OnFrameOutput(frame, env);
+						OnFrameOutput(dec, frame, env);
 #endif
 					}
 				}
 			}
 			av_packet_unref(&packet);
-			if (lastDecodeFrame >= goal) {
+			if (dec.lastDecodeFrame >= goal) {
 				return;
 			}
 		}
 #if ENABLE_FFMPEG_FILTER
-		if (bufferSrcCtx) {
+		if (dec.bufferSrcCtx) {
 			// Xg[͑Sēǂݎ̂ŃtB^flush
-			InputFrameFilter(nullptr, true, env);
+			InputFrameFilter(dec, nullptr, true, env);
 		}
 #endif
 	}
 
+	// mutexbNČĂԂ
 	void registerFailedFrames(int begin, int end, int replace, IScriptEnvironment* env)
 	{
 		for (int f = begin; f < end; ++f) {
@@ -657,14 +930,119 @@ class AMTSource : public IClip, AMTObject
 		}
 	}
 
+	// nfR[hfR[_IŎgpɂ
+	Decoder& AcquireDecoder(int n) {
+		std::unique_lock<std::mutex> lock(poolMutex);
+		while (true) {
+			int dist = seekDistance;
+			Decoder* forward = nullptr;
+			Decoder* idle = nullptr;
+			bool coveredByBusy = false;
+			for (auto& d : decoders) {
+				if (d->busy) {
+					// fR[hGOPɊ܂܂邩ȂȂÎ҂
+					if (n >= frames[d->goal].keyFrame && n < d->goal + dist) {
+						coveredByBusy = true;
+					}
+				}
+				else if (d->position != -1 && n > d->position && n < d->position + dist) {
+					// Oɂ߂邾ŃfR[hł
+					forward = d.get();
+				}
+				else if (idle == nullptr || d->lastUsed < idle->lastUsed) {
+					idle = d.get();
+				}
+			}
+			Decoder* dec = forward ? forward : coveredByBusy ? nullptr : idle;
+			if (dec != nullptr) {
+				dec->busy = true;
+				dec->goal = n;
+				dec->goalFrame = nullptr;
+				return *dec;
+			}
+			poolCond.wait(lock);
+		}
+	}
+
+	void ReleaseDecoder(Decoder& dec) {
+		std::lock_guard<std::mutex> lock(poolMutex);
+		dec.busy = false;
+		dec.position = dec.lastDecodeFrame;
+		dec.lastUsed = ++useCounter;
+		poolCond.notify_all();
+	}
+
+	void DecodeFrame(Decoder& dec, int n, IScriptEnvironment* env)
+	{
+		// ҂ĂԂɑ̃fR[_fR[hȂ
+		if (TouchCache(n, &dec.goalFrame)) {
+			return;
+		}
+
+		if (dec.lastDecodeFrame != -1 && n > dec.lastDecodeFrame && n < dec.lastDecodeFrame + seekDistance) {
+			// Oɂ߂
+			DecodeLoop(dec, n, env);
+			return;
+		}
+
+		// V[NăfR[h
+		// GOPCfbNXɊmFς݂̃V[Nʒu΂n߂
+		int gop, keyNum;
+		int64_t fileOffset;
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			gop = gopIndex.find(frames[n].keyFrame);
+			keyNum = gopIndex.get(gop).seekKey;
+			fileOffset = gopIndex.get(gop).fileOffset;
+		}
+		for (int i = 0; ; ++i) {
+			if (av_seek_frame(dec.inputCtx(), -1, fileOffset / 188 * 188, AVSEEK_FLAG_BYTE) < 0) {
+				THROW(FormatException, "av_seek_frame failed");
+			}
+			ResetDecoder(dec, env);
+			DecodeLoop(dec, n, env);
+			std::lock_guard<std::mutex> guard(mutex);
+			if (dec.goalFrame) {
+				// fR[h
+				seekDistance = std::max<int>(seekDistance, n - keyNum);
+				gopIndex.setSeekDistance(seekDistance);
+				gopIndex.setSeekKey(gop, keyNum, fileOffset);
+				break;
+			}
+			if (keyNum <= 0) {
+				// ȏ߂Ȃ
+				// nlastDecodeFrame܂łfR[hsƂ
+				registerFailedFrames(n, dec.lastDecodeFrame, dec.lastDecodeFrame, env);
+				break;
+			}
+			if (dec.lastDecodeFrame >= 0 && dec.lastDecodeFrame < n) {
+				// f[^ȂăS[ɓBłȂ
+				// ̃t[͑SăfR[hsƂ
+				registerFailedFrames(dec.lastDecodeFrame + 1, (int)frames.size(), dec.lastDecodeFrame, env);
+				break;
+			}
+			if (i == 2) {
+				// fR[hs
+				// nlastDecodeFrame܂łfR[hsƂ
+				registerFailedFrames(n, dec.lastDecodeFrame, dec.lastDecodeFrame, env);
+				break;
+			}
+			keyNum -= std::max(5, keyNum - frames[keyNum - 1].keyFrame);
+			keyNum = std::max(0, keyNum);
+			fileOffset = frames[keyNum].fileOffset;
+		}
+	}
+
 public:
 	AMTSource(AMTContext& ctx,
 		const tstring& srcpath,
 		const tstring& audiopath,
+		const tstring& aacpath,
 		const VideoFormat& vfmt, const AudioFormat& afmt,
 		const std::vector<FilterSourceFrame>& frames,
 		const std::vector<FilterAudioFrame>& audioFrames,
 		const DecoderSetting& decoderSetting,
+		const tstring& gopIndexPath,
 		const char* filterdesc,
 		bool outputQP,
 		IScriptEnvironment* env)
@@ -674,15 +1052,19 @@ public:
 		, audioFrames(audioFrames)
 		, filterdesc(filterdesc)
 		, outputQP(outputQP)
-		, inputCtx(srcpath)
+		, useCounter(0)
+		, numDecoders(std::max(1, decoderSetting.numDecoders))
+		, cacheBudget((int64_t)std::max(0, decoderSetting.cacheBudgetMB) * 1024 * 1024)
+		, cacheBytes(0)
+		, poolBytes(0)
+		, peakBytes(0)
+		, numHit(0)
+		, numMiss(0)
+		, numEvict(0)
 		, vi()
-		, waveFile(audiopath, _T("rb"))
-#if ENABLE_FFMPEG_FILTER
-		, bufferSrcCtx()
-		, bufferSinkCtx()
-#endif
+		, waveReader(ctx, audiopath, aacpath)
 		, seekDistance(10)
-		, lastDecodeFrame(-1)
+		, gopIndexPath(gopIndexPath)
 	{
 #if !ENABLE_FFMPEG_FILTER
 		if (this->filterdesc.size()) {
@@ -691,20 +1073,41 @@ public:
 #endif
 		MakeVideoInfo(vfmt, afmt);
 
-		if (avformat_find_stream_info(inputCtx(), NULL) < 0) {
-			env->ThrowError("avformat_find_stream_info failed");
-		}
-		videoStream = GetVideoStream(inputCtx());
-		if (videoStream == NULL) {
-			env->ThrowError("Could not find video stream ...");
+		// GOPCfbNX
+		if (gopIndexPath.size() == 0 || !gopIndex.load(gopIndexPath, frames)) {
+			gopIndex.build(frames);
 		}
+		seekDistance = gopIndex.getSeekDistance();
 
-		// 
-		ResetDecoder(env);
-		UpdateVideoInfo(env);
+		for (int i = 0; i < numDecoders; ++i) {
+			decoders.emplace_back(new Decoder(srcpath));
+			Decoder& dec = *decoders.back();
+			if (avformat_find_stream_info(dec.inputCtx(), NULL) < 0) {
+				env->ThrowError("avformat_find_stream_info failed");
+			}
+			dec.videoStream = GetVideoStream(dec.inputCtx());
+			if (dec.videoStream == NULL) {
+				env->ThrowError("Could not find video stream ...");
+			}
+
+			// 
+			ResetDecoder(dec, env);
+		}
+		UpdateVideoInfo(*decoders[0], env);
 	}
 
 	~AMTSource() {
+		// V[Nʒuۑ
+		if (gopIndexPath.size() > 0 && gopIndex.isDirty()) {
+			try {
+				gopIndex.save(gopIndexPath);
+			}
+			catch (const Exception&) {
+				// ۑłȂĂɎs낪KvɂȂ邾
+			}
+		}
+		ctx.infoF("[AMTSource] LbV qbg:%lld ~X:%lld j:%lld őgp:%.1fMB",
+			numHit, numMiss, numEvict, peakBytes / (1024.0 * 1024.0));
 		// LbV폜
 		while (recentAccessed.size() > 0) {
 			CacheFrame* pdel = recentAccessed.back().value;
@@ -712,6 +1115,9 @@ public:
 			recentAccessed.erase(recentAccessed.it(&pdel->listNode));
 			delete pdel;
 		}
+		for (CacheFrame* pdel : freeNodes) {
+			delete pdel;
+		}
 	}
 
 	void TransferStreamInfo(std::unique_ptr<AMTSourceData>&& streamInfo) {
@@ -720,68 +1126,57 @@ public:
 
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env)
 	{
-		std::lock_guard<std::mutex> guard(mutex);
-
-		// LbVɂΕԂ
-		auto it = frameCache.find(n);
-		if (it != frameCache.end()) {
-			UpdateAccessed(it->value);
-			return it->value->data;
-		}
-
-		// fR[hłȂt[͒ut[ɒu
-		if (failedMap.find(n) != failedMap.end()) {
-			n = failedMap[n];
-		}
-
-		// LbVɂȂ̂ŃfR[h
-		if (lastDecodeFrame != -1 && n > lastDecodeFrame && n < lastDecodeFrame + seekDistance) {
-			// Oɂ߂
-			DecodeLoop(n, env);
-		}
-		else {
-			// V[NăfR[h
-			int keyNum = frames[n].keyFrame;
-			for (int i = 0; ; ++i) {
-				int64_t fileOffset = frames[keyNum].fileOffset / 188 * 188;
-				if (av_seek_frame(inputCtx(), -1, fileOffset, AVSEEK_FLAG_BYTE) < 0) {
-					THROW(FormatException, "av_seek_frame failed");
+		for (int retry = 0; ; ++retry) {
+			{
+				std::lock_guard<std::mutex> guard(mutex);
+
+				// LbVɂΕԂ
+				auto it = frameCache.find(n);
+				if (it != frameCache.end()) {
+					++numHit;
+					UpdateAccessed(it->value);
+					return it->value->data;
 				}
-				ResetDecoder(env);
-				DecodeLoop(n, env);
-				if (frameCache.find(n) != frameCache.end()) {
-					// fR[h
-					seekDistance = std::max(seekDistance, n - keyNum);
-					break;
+				if (retry == 0) {
+					++numMiss;
 				}
-				if (keyNum <= 0) {
-					// ȏ߂Ȃ
-					// nlastDecodeFrame܂łfR[hsƂ
-					registerFailedFrames(n, lastDecodeFrame, lastDecodeFrame, env);
-					break;
+
+				// fR[hłȂt[͒ut[ɒu
+				if (failedMap.find(n) != failedMap.end()) {
+					n = failedMap[n];
 				}
-				if (lastDecodeFrame >= 0 && lastDecodeFrame < n) {
-					// f[^ȂăS[ɓBłȂ
-					// ̃t[͑SăfR[hsƂ
-					registerFailedFrames(lastDecodeFrame + 1, (int)frames.size(), lastDecodeFrame, env);
-					break;
+				else if (retry >= 3) {
+					// ut[܂Ȃ
+					return ForceGetFrame(n, env);
 				}
-				if (i == 2) {
-					// fR[hs
-					// nlastDecodeFrame܂łfR[hsƂ
-					registerFailedFrames(n, lastDecodeFrame, lastDecodeFrame, env);
-					break;
-				}
-				keyNum -= std::max(5, keyNum - frames[keyNum - 1].keyFrame);
 			}
-		}
 
-		return ForceGetFrame(n, env);
+			// LbVɂȂ̂ŃfR[h
+			// fR[ht[̓LbVǂoĂԂ悤ɃfR[_󂯎
+			Decoder& dec = AcquireDecoder(n);
+			PVideoFrame frame;
+			try {
+				DecodeFrame(dec, n, env);
+				frame = dec.goalFrame;
+				dec.goalFrame = nullptr;
+			}
+			catch (...) {
+				dec.goalFrame = nullptr;
+				ReleaseDecoder(dec);
+				throw;
+			}
+			ReleaseDecoder(dec);
+
+			if (frame) {
+				return frame;
+			}
+			// fR[hłȂ̂Œut[Ŏ蒼
+		}
 	}
 
 	void __stdcall GetAudio(void* buf, __int64 start, __int64 count, IScriptEnvironment* env)
 	{
-		std::lock_guard<std::mutex> guard(mutex);
+		std::lock_guard<std::mutex> guard(audioMutex);
 
 		if (audioFrames.size() == 0) return;
 
@@ -797,15 +1192,7 @@ public:
 				(int)(frameWaveLength - frameOffset * sampleBytes),
 				(int)count * sampleBytes);
 
-			if (audioFrames[(size_t)frameIndex].waveLength != 0) {
-				// waveȂǂ
-				waveFile.seek(audioFrames[(size_t)frameIndex].waveOffset + frameOffset * sampleBytes, SEEK_SET);
-				waveFile.read(MemoryChunk(ptr, readBytes));
-			}
-			else {
-				// Ȃꍇ̓[߂
-				memset(ptr, 0x00, readBytes);
-			}
+			waveReader.read(audioFrames[(size_t)frameIndex], (int)(frameOffset * sampleBytes), MemoryChunk(ptr, readBytes));
 
 			ptr += readBytes;
 			count -= readBytes / sampleBytes;
@@ -836,19 +1223,28 @@ void SaveAMTSource(
 	const tstring& savepath,
 	const tstring& srcpath,
 	const tstring& audiopath,
+	const tstring& aacpath,
 	const VideoFormat& vfmt, const AudioFormat& afmt,
 	const std::vector<FilterSourceFrame>& frames,
 	const std::vector<FilterAudioFrame>& audioFrames,
-	const DecoderSetting& decoderSetting)
+	const DecoderSetting& decoderSetting,
+	const tstring& gopIndexPath)
 {
 	File file(savepath, _T("wb"));
 	file.writeArray(std::vector<tchar>(srcpath.begin(), srcpath.end()));
 	file.writeArray(std::vector<tchar>(audiopath.begin(), audiopath.end()));
+	file.writeArray(std::vector<tchar>(aacpath.begin(), aacpath.end()));
 	file.writeValue(vfmt);
 	file.writeValue(afmt);
 	file.writeArray(frames);
 	file.writeArray(audioFrames);
 	file.writeValue(decoderSetting);
+	file.writeArray(std::vector<tchar>(gopIndexPath.begin(), gopIndexPath.end()));
+
+	// GOPCfbNXTS͂ŕL[t[Ă
+	GopIndex gopIndex;
+	gopIndex.build(frames);
+	gopIndex.save(gopIndexPath);
 }
 
 PClip LoadAMTSource(const tstring& loadpath, const char* filterdesc, bool outputQP, IScriptEnvironment* env)
@@ -858,14 +1254,18 @@ PClip LoadAMTSource(const tstring& loadpath, const char* filterdesc, bool output
 	tstring srcpath(srcpathv.begin(), srcpathv.end());
 	auto& audiopathv = file.readArray<tchar>();
 	tstring audiopath(audiopathv.begin(), audiopathv.end());
+	auto& aacpathv = file.readArray<tchar>();
+	tstring aacpath(aacpathv.begin(), aacpathv.end());
 	VideoFormat vfmt = file.readValue<VideoFormat>();
 	AudioFormat afmt = file.readValue<AudioFormat>();
 	auto data = std::unique_ptr<AMTSourceData>(new AMTSourceData());
 	data->frames = file.readArray<FilterSourceFrame>();
 	data->audioFrames = file.readArray<FilterAudioFrame>();
 	DecoderSetting decoderSetting = file.readValue<DecoderSetting>();
+	auto& gopIndexPathv = file.readArray<tchar>();
+	tstring gopIndexPath(gopIndexPathv.begin(), gopIndexPathv.end());
 	AMTSource* src = new AMTSource(*g_ctx_for_plugin_filter,
-		srcpath, audiopath, vfmt, afmt, data->frames, data->audioFrames, decoderSetting, filterdesc, outputQP, env);
+		srcpath, audiopath, aacpath, vfmt, afmt, data->frames, data->audioFrames, decoderSetting, gopIndexPath, filterdesc, outputQP, env);
 	src->TransferStreamInfo(std::move(data));
 	return src;
 }
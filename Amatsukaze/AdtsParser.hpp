@@ -106,25 +106,114 @@ struct AdtsHeader {
 };
 #endif
 
+// ADTSt[2chɃ_E~bNXăfR[h
+class AdtsDecoder : public AMTObject {
+public:
+	AdtsDecoder(AMTContext&ctx)
+		: AMTObject(ctx)
+		, hAacDec(NULL)
+	{ }
+	~AdtsDecoder() {
+		closeDecoder();
+	}
+
+	// 2ch̃f[^ꂽtrue
+	// fR[h͂ł2chɂłȂꍇchannelErrortrueɂ
+	bool decode(uint8_t* ptr, int len, NeAACDecFrameInfo& frameInfo, void*& samples, bool& channelError) {
+		channelError = false;
+		if (hAacDec == NULL) {
+			resetDecoder(MemoryChunk(ptr, len));
+		}
+		samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
+		if (frameInfo.error != 0) {
+			// tH[}bgςƃG[f̂ŏĂPH킹
+			// ςȎgNeroAACN̓Xg[̓r
+			// tH[}bgς邱Ƃz肵ĂȂ񂾂dȂ
+			//ifixed headerςȂĂ`l\ς邱Ƃ邩ǂł݂ȂƕȂj
+			resetDecoder(MemoryChunk(ptr, len));
+			samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
+		}
+		if (frameInfo.error != 0) {
+			return false;
+		}
+		// _E~bNXĂ̂2chɂȂ͂
+		if (getNumChannels(frameInfo) != 2) {
+			// tH[}bgςƃoO2chɂłȂƂ̂ŁAĂPH킹
+			// ςȎgNeroAACN̓Xg[̓r(ry
+			resetDecoder(MemoryChunk(ptr, len));
+			samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
+		}
+		if (frameInfo.error != 0 || getNumChannels(frameInfo) != 2) {
+			channelError = true;
+			return false;
+		}
+		return true;
+	}
+
+	// decodeŃfR[_蒼
+	void reset() {
+		closeDecoder();
+	}
+
+	static int getNumChannels(const NeAACDecFrameInfo& frameInfo) {
+		return frameInfo.num_front_channels +
+			frameInfo.num_back_channels + frameInfo.num_side_channels + frameInfo.num_lfe_channels;
+	}
+
+private:
+	NeAACDecHandle hAacDec;
+
+	void closeDecoder() {
+		if (hAacDec != NULL) {
+			NeAACDecClose(hAacDec);
+			hAacDec = NULL;
+		}
+	}
+
+	bool resetDecoder(MemoryChunk data) {
+		closeDecoder();
+
+		hAacDec = NeAACDecOpen();
+		NeAACDecConfigurationPtr conf = NeAACDecGetCurrentConfiguration(hAacDec);
+		conf->outputFormat = FAAD_FMT_16BIT;
+		conf->downMatrix = 1; // WAVo͉͂͗pȂ̂2chΏ\
+		NeAACDecSetConfiguration(hAacDec, conf);
+
+		unsigned long samplerate;
+		unsigned char channels;
+		if (NeAACDecInit(hAacDec, data.data, (int)data.length, &samplerate, &channels)) {
+			ctx.warn("NeAACDecInitɎs");
+			return false;
+		}
+		return true;
+	}
+};
+
 class AdtsParser : public AMTObject {
 public:
 	AdtsParser(AMTContext&ctx)
 		: AMTObject(ctx)
-		, hAacDec(NULL)
+		, decoder(ctx)
 		, bytesConsumed_(0)
 		, lastPTS_(-1)
 		, syncOK(false)
+		, deferDecode(false)
 	{
 		createChannelsMap();
 	}
-	~AdtsParser() {
-		closeDecoder();
-	}
 
 	virtual void reset() {
 		decodedBuffer.release();
 	}
 
+	// trueɂƃ`l\wb_Ō܂t[
+	// tH[}bgĂfR[hɏo͂idecodeDeferredɂȂj
+	// tH[}bg͓wb_̃t[ŏɃfR[hƂ̌ʂg
+	// ŃfR[hɎst[́AfR[hꍇƓɂȂ悤ĂяoŎ̂Ă邱
+	void setDeferDecode(bool defer) {
+		deferDecode = defer;
+	}
+
 	virtual bool inputFrame(MemoryChunk frame__, std::vector<AudioFrameData>& info, int64_t PTS) {
 		info.clear();
 		decodedBuffer.clear();
@@ -171,99 +260,57 @@ public:
 				if (header.parse(ptr, len)
 					&& header.frame_length <= len)
 				{
-					// Xg[͖͂̂ʓ|Ȃ̂ŃfR[hႤ
-					if (hAacDec == NULL) {
-						resetDecoder(MemoryChunk(ptr, len));
-					}
-					NeAACDecFrameInfo frameInfo;
-					void* samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
-					if (frameInfo.error != 0) {
-						// tH[}bgςƃG[f̂ŏĂPH킹
-						// ςȎgNeroAACN̓Xg[̓r
-						// tH[}bgς邱Ƃz肵ĂȂ񂾂dȂ
-						//ifixed headerςȂĂ`l\ς邱Ƃ邩ǂł݂ȂƕȂj
-						resetDecoder(MemoryChunk(ptr, len));
-						samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
-					}
-					if (frameInfo.error == 0) {
-						// _E~bNXĂ̂2chɂȂ͂
-						int numChannels = frameInfo.num_front_channels +
-							frameInfo.num_back_channels + frameInfo.num_side_channels + frameInfo.num_lfe_channels;
-
-						if (numChannels != 2) {
-							// tH[}bgςƃoO2chɂłȂƂ̂ŁAĂPH킹
-							// ςȎgNeroAACN̓Xg[̓r(ry
-							resetDecoder(MemoryChunk(ptr, len));
-							samples = NeAACDecDecode(hAacDec, &frameInfo, ptr, len);
-
-							numChannels = frameInfo.num_front_channels +
-								frameInfo.num_back_channels + frameInfo.num_side_channels + frameInfo.num_lfe_channels;
-						}
-
-						if (frameInfo.error != 0 || numChannels != 2) {
-							ctx.incrementCounter(AMT_ERR_DECODE_AUDIO);
-							ctx.warn("t[𐳂fR[hł܂ł");
+					AudioFrameData frameData;
+					if (decodeFrame(ptr, len, frameData)) {
+						// Xg[Ȃ frameInfo.bytesconsumed == header.frame_length ƂȂ͂
+						// Xg[sƓɂȂȂƂ
+						// ̏ꍇA header.frame_length D悷
+						//ĩ̕t[fR[hmオ̂
+						//  L-SMASHheader.frame_lengthăt[XLbvĂ̂
+						//  ꂪۂ̃t[ƈvĂȂƗ̂Łj
+						//frameData.codedDataSize = frameInfo.bytesconsumed;
+						frameData.codedDataSize = header.frame_length;
+
+						// codedBufferf[^ւ̃|C^Ă̂
+						// codedBufferɂ͐GȂ悤ɒӁI
+						frameData.codedData = ptr;
+						// AutoBuffer̓Ċmۂ̂ŃfR[hf[^ւ̃|C^͌œ
+
+						// PTSvZ
+						int64_t duration = 90000 * frameData.numSamples / frameData.format.sampleRate;
+						if (ibytes < prevDataSize) {
+							// t[̊Jñ݂pPbg擪Oꍇ
+							// i܂APESpPbg̋Eƃt[̋EvȂꍇj
+							// ݂̃pPbgPTS͓KpłȂ̂őÕpPbg̒l
+							frameData.PTS = lastPTS_;
+							lastPTS_ += duration;
+							// ݂̃pPbgȂ΃t[o͂łȂ̂ŁAo͂t[݂͌̃pPbg̈ꕔ܂ނ͂
+							ASSERT(ibytes + header.frame_length > prevDataSize);
+							// ܂APTŚi΁j̃t[PTSł
+							if (PTS >= 0) {
+								lastPTS_ = PTS;
+								PTS = -1;
+							}
 						}
 						else {
-							decodedBuffer.add(MemoryChunk((uint8_t*)samples, frameInfo.samples * 2));
-
-							AudioFrameData frameData;
-							frameData.numSamples = frameInfo.original_samples / numChannels;
-							frameData.numDecodedSamples = frameInfo.samples / numChannels;
-							frameData.format.channels = getAudioChannels(header, frameInfo);
-							frameData.format.sampleRate = frameInfo.samplerate;
-							
-							// Xg[Ȃ frameInfo.bytesconsumed == header.frame_length ƂȂ͂
-							// Xg[sƓɂȂȂƂ
-							// ̏ꍇA header.frame_length D悷
-							//ĩ̕t[fR[hmオ̂
-							//  L-SMASHheader.frame_lengthăt[XLbvĂ̂
-							//  ꂪۂ̃t[ƈvĂȂƗ̂Łj
-							//frameData.codedDataSize = frameInfo.bytesconsumed;
-							frameData.codedDataSize = header.frame_length;
-
-							// codedBufferf[^ւ̃|C^Ă̂
-							// codedBufferɂ͐GȂ悤ɒӁI
-							frameData.codedData = ptr;
-							frameData.decodedDataSize = frameInfo.samples * 2;
-							// AutoBuffer̓Ċmۂ̂ŃfR[hf[^ւ̃|C^͌œ
-
-							// PTSvZ
-							int64_t duration = 90000 * frameData.numSamples / frameData.format.sampleRate;
-							if (ibytes < prevDataSize) {
-								// t[̊Jñ݂pPbg擪Oꍇ
-								// i܂APESpPbg̋Eƃt[̋EvȂꍇj
-								// ݂̃pPbgPTS͓KpłȂ̂őÕpPbg̒l
-								frameData.PTS = lastPTS_;
-								lastPTS_ += duration;
-								// ݂̃pPbgȂ΃t[o͂łȂ̂ŁAo͂t[݂͌̃pPbg̈ꕔ܂ނ͂
-								ASSERT(ibytes + header.frame_length > prevDataSize);
-								// ܂APTŚi΁j̃t[PTSł
-								if (PTS >= 0) {
-									lastPTS_ = PTS;
-									PTS = -1;
-								}
-							}
-							else {
-								// PESpPbg̋Eƃt[̋Evꍇ
-								// PESpPbg2Ԗڈȍ~̃t[
-								if (PTS >= 0) {
-									lastPTS_ = PTS;
-									PTS = -1;
-								}
-								frameData.PTS = lastPTS_;
-								lastPTS_ += duration;
+							// PESpPbg̋Eƃt[̋Evꍇ
+							// PESpPbg2Ԗڈȍ~̃t[
+							if (PTS >= 0) {
+								lastPTS_ = PTS;
+								PTS = -1;
 							}
+							frameData.PTS = lastPTS_;
+							lastPTS_ += duration;
+						}
 
-							info.push_back(frameData);
+						info.push_back(frameData);
 
-							// f[^i߂
-							//ASSERT(frameInfo.bytesconsumed == header.frame_length);
-							ibytes += header.frame_length - 1;
-							bytesConsumed_ = ibytes + 1;
+						// f[^i߂
+						//ASSERT(frameInfo.bytesconsumed == header.frame_length);
+						ibytes += header.frame_length - 1;
+						bytesConsumed_ = ibytes + 1;
 
-							syncOK = true;
-						}
+						syncOK = true;
 					}
 				}
 				else {
@@ -280,8 +327,13 @@ public:
 		// fR[hf[^̃|C^
 		uint8_t* decodedData = decodedBuffer.ptr();
 		for (int i = 0; i < (int)info.size(); ++i) {
-			info[i].decodedData = (uint16_t*)decodedData;
-			decodedData += info[i].decodedDataSize;
+			if (info[i].decodeDeferred) {
+				info[i].decodedData = nullptr;
+			}
+			else {
+				info[i].decodedData = (uint16_t*)decodedData;
+				decodedData += info[i].decodedDataSize;
+			}
 		}
 		ASSERT(decodedData - decodedBuffer.ptr() == decodedBuffer.size());
 
@@ -289,7 +341,15 @@ public:
 	}
 
 private:
-	NeAACDecHandle hAacDec;
+	// fR[hēt[
+	struct DecodedFormat {
+		int numSamples;
+		int numDecodedSamples;
+		int decodedDataSize;
+		AudioFormat format;
+	};
+
+	AdtsDecoder decoder;
 	AdtsHeader header;
 	std::map<int64_t, AUDIO_CHANNELS> channelsMap;
 
@@ -301,28 +361,64 @@ private:
 	AutoBuffer decodedBuffer;
 	bool syncOK;
 
-	void closeDecoder() {
-		if (hAacDec != NULL) {
-			NeAACDecClose(hAacDec);
-			hAacDec = NULL;
+	bool deferDecode;
+	// wb_̒l -> fR[hēꂽtH[}bg
+	std::map<int, DecodedFormat> formatCache;
+
+	// header̃t[̏frameDataɓ
+	// t[Ƃďo͂łȂꍇfalse
+	bool decodeFrame(uint8_t* ptr, int len, AudioFrameData& frameData) {
+		// channel_configuration0̂Ƃ̓fR[hȂƃ`l\Ȃ
+		bool canDefer = deferDecode && header.channel_configuration > 0;
+		int formatKey = (header.profile << 8) | (header.sampling_frequency_index << 4) | header.channel_configuration;
+
+		if (canDefer) {
+			auto it = formatCache.find(formatKey);
+			if (it != formatCache.end()) {
+				const DecodedFormat& fmt = it->second;
+				frameData.numSamples = fmt.numSamples;
+				frameData.numDecodedSamples = fmt.numDecodedSamples;
+				frameData.decodedDataSize = fmt.decodedDataSize;
+				frameData.format = fmt.format;
+				frameData.decodeDeferred = true;
+				return true;
+			}
 		}
-	}
-
-	bool resetDecoder(MemoryChunk data) {
-		closeDecoder();
-
-		hAacDec = NeAACDecOpen();
-		NeAACDecConfigurationPtr conf = NeAACDecGetCurrentConfiguration(hAacDec);
-		conf->outputFormat = FAAD_FMT_16BIT;
-		conf->downMatrix = 1; // WAVo͉͂͗pȂ̂2chΏ\
-		NeAACDecSetConfiguration(hAacDec, conf);
 
-		unsigned long samplerate;
-		unsigned char channels;
-		if (NeAACDecInit(hAacDec, data.data, (int)data.length, &samplerate, &channels)) {
-			ctx.warn("NeAACDecInitɎs");
+		// Xg[͖͂̂ʓ|Ȃ̂ŃfR[hႤ
+		NeAACDecFrameInfo frameInfo;
+		void* samples;
+		bool channelError;
+		if (!decoder.decode(ptr, len, frameInfo, samples, channelError)) {
+			if (channelError) {
+				ctx.incrementCounter(AMT_ERR_DECODE_AUDIO);
+				ctx.warn("t[𐳂fR[hł܂ł");
+			}
 			return false;
 		}
+
+		int numChannels = AdtsDecoder::getNumChannels(frameInfo);
+		frameData.numSamples = frameInfo.original_samples / numChannels;
+		frameData.numDecodedSamples = frameInfo.samples / numChannels;
+		frameData.format.channels = getAudioChannels(header, frameInfo);
+		frameData.format.sampleRate = frameInfo.samplerate;
+		frameData.decodedDataSize = frameInfo.samples * 2;
+
+		if (canDefer) {
+			// ̃t[fR[hʂ͎g킸ɌŃfR[h
+			//ifR[_̏ԂŃfR[h鑤Ƒ邽߁j
+			DecodedFormat fmt;
+			fmt.numSamples = frameData.numSamples;
+			fmt.numDecodedSamples = frameData.numDecodedSamples;
+			fmt.decodedDataSize = frameData.decodedDataSize;
+			fmt.format = frameData.format;
+			formatCache[formatKey] = fmt;
+			frameData.decodeDeferred = true;
+		}
+		else {
+			decodedBuffer.add(MemoryChunk((uint8_t*)samples, frameData.decodedDataSize));
+			frameData.decodeDeferred = false;
+		}
 		return true;
 	}
 
@@ -42,6 +42,9 @@ static void printHelp(const tchar* bin) {
 		"                      w肪Ȃꍇ̓rbg[gIvVǉȂ\n"
 		"  -bcm|--bitrate-cm <float>   CM肳ꂽƂ̃rbg[g{\n"
 		"  --2pass             2passGR[h\n"
+		"  --filter-cache      2pXڂ̓tB^s1pXڂ̃tB^o͂ۑt@C͂\n"
+		"                      i8bit 4:2:0UtVideoAȊO͖kŕۑ̂ňꎞtH_ɏ\ȋ󂫂Kvj\n"
+		"  --filter-cache-mmap --filter-cache̖kt@C}bvēǂݍ\n"
 		"  --splitsub          CȊÕtH[}bg͌Ȃ\n"
 		"  -aet|--audio-encoder-type <^Cv> GR[_[]"
 		"                      ΉGR[_: neroAac, qaac, fdkaac\n"
@@ -59,6 +62,14 @@ static void printHelp(const tchar* bin) {
 		"                      gp\fR[_: default,QSV,CUVID\n"
 		"  --h264decoder <fR[_>  H264pfR[_[default]\n"
 		"                      gp\fR[_: default,QSV,CUVID\n"
+		"  --source-decoders <l> ԃt@C̓ǂݍ݂ŕʁXGOPɃfR[hfR[_[1]\n"
+		"  --source-cache-mb <l> ԃt@Cǂݍ݂̃t[LbV(MB)B0Ȃ疇݂̂Ő[0]\n"
+		"  --parallel-demux    TS͂̓ǂݍ݁ÉE݁EfR[hʃXbhŕɍs\n"
+		"  --lazy-wave         wavet@C炸AKvȂƂɒԉt@CfR[h\n"
+		"  --logo-scan-threads <l> S͂̕]ɍsXbhB0Ȃ񉻂Ȃ[0]\n"
+		"  --reuse-logo-analysis Sp̉͂S͂ƓɍsAGR[hɍĉ͂Ȃ\n"
+		"  --cm-analyze-parallel <l> ft@CꍇɃSECM͂𓯎ɍső吔[1]\n"
+		"  --mux-parallel <l> o̓t@Cꍇmuxer𓯎Ɏső吔[1]\n"
 		"  --chapter           `v^[ECM͂s\n"
 		"  --subtitles         \n"
 		"  --nicojk            jRjRRgǉ\n"
@@ -189,6 +200,8 @@ static std::unique_ptr<ConfigWrapper> parseArgs(AMTContext& ctx, int argc, const
 	conf.bitrateCM = 1.0;
 	conf.x265TimeFactor = 0.25;
 	conf.serviceId = -1;
+	conf.maxCMAnalyzeParallel = 1;
+	conf.maxMuxParallel = 1;
 	conf.cmoutmask = 1;
 	conf.nicojkmask = 1;
 	conf.maxframes = 30 * 300;
@@ -270,6 +283,13 @@ static std::unique_ptr<ConfigWrapper> parseArgs(AMTContext& ctx, int argc, const
 		else if (key == _T("--2pass")) {
 			conf.twoPass = true;
 		}
+		else if (key == _T("--filter-cache")) {
+			conf.filterCache = true;
+		}
+		else if (key == _T("--filter-cache-mmap")) {
+			conf.filterCache = true;
+			conf.filterCacheMmap = true;
+		}
 		else if (key == _T("--splitsub")) {
 			conf.splitSub = true;
 		}
@@ -343,9 +363,33 @@ static std::unique_ptr<ConfigWrapper> parseArgs(AMTContext& ctx, int argc, const
 				PRINTF("--h264decoder̎w肪ԈĂ܂: %" PRITSTR "\n", arg.c_str());
 			}
 		}
+		else if (key == _T("--source-decoders")) {
+			conf.decoderSetting.numDecoders = std::stoi(getParam(argc, argv, i++));
+		}
+		else if (key == _T("--source-cache-mb")) {
+			conf.decoderSetting.cacheBudgetMB = std::stoi(getParam(argc, argv, i++));
+		}
 		else if (key == _T("-eb") || key == _T("--encode-buffer")) {
 			conf.numEncodeBufferFrames = std::stoi(getParam(argc, argv, i++));
 		}
+		else if (key == _T("--parallel-demux")) {
+			conf.parallelDemux = true;
+		}
+		else if (key == _T("--lazy-wave")) {
+			conf.lazyWave = true;
+		}
+		else if (key == _T("--logo-scan-threads")) {
+			conf.numLogoScanThreads = std::stoi(getParam(argc, argv, i++));
+		}
+		else if (key == _T("--reuse-logo-analysis")) {
+			conf.reuseLogoAnalysis = true;
+		}
+		else if (key == _T("--cm-analyze-parallel")) {
+			conf.maxCMAnalyzeParallel = std::stoi(getParam(argc, argv, i++));
+		}
+		else if (key == _T("--mux-parallel")) {
+			conf.maxMuxParallel = std::stoi(getParam(argc, argv, i++));
+		}
 		else if (key == _T("--ignore-no-logo")) {
 			conf.ignoreNoLogo = true;
 		}
@@ -661,6 +705,30 @@ static int amatsukazeTranscodeMain(AMTContext& ctx, const ConfigWrapper& setting
 			test::PrintfBug(ctx, setting);
 		else if (mode == _T("test_resource"))
 			test::ResourceTest(ctx, setting);
+		else if (mode == _T("test_tsparser_perf"))
+			test::TsPacketParserPerf(ctx, setting);
+		else if (mode == _T("test_tsparser"))
+			test::TsPacketParserStrideTest(ctx, setting);
+		else if (mode == _T("test_logo_kernel"))
+			test::LogoKernelTest(ctx, setting);
+		else if (mode == _T("test_logoframe_filter_perf"))
+			test::LogoFrameFilterPerf(ctx, setting);
+		else if (mode == _T("test_datapump_perf"))
+			test::DataPumpPerf(ctx, setting);
+		else if (mode == _T("test_h264parser_perf"))
+			test::H264ParserPerf(ctx, setting);
+		else if (mode == _T("test_zone_perf"))
+			test::BitrateZonesPerf(ctx, setting);
+		else if (mode == _T("test_logo_analyze_perf"))
+			test::LogoAnalyzePerf(ctx, setting);
+		else if (mode == _T("test_scratch_arena"))
+			test::ScratchArenaTest(ctx, setting);
+		else if (mode == _T("test_logo_analysis_file"))
+			test::LogoAnalysisFileTest(ctx, setting);
+		else if (mode == _T("test_logo_scan_frames"))
+			test::LogoScanFrameStoreTest(ctx, setting);
+		else if (mode == _T("test_filter_encode_multi"))
+			test::FilterEncodeMultiTest(ctx, setting);
 
 		else
 			ctx.errorF("--mode̎w肪ԈĂ܂: %s\n", mode.c_str());
@@ -715,4 +715,1432 @@ static int ResourceTest(AMTContext& ctx, const ConfigWrapper& setting)
 	return 0;
 }
 
+// ͂Săobt@ɃRs[1oCgTĂȑOTsPacketParser
+// rp
+class ReferenceTsPacketParser {
+	enum { CHECK_PACKET_NUM = 8 };
+public:
+	ReferenceTsPacketParser() : syncOK(false) { }
+
+	void inputTS(MemoryChunk data) {
+		buffer.add(data);
+		if (syncOK) {
+			outPackets();
+		}
+		while (buffer.size() >= CHECK_PACKET_NUM*TS_PACKET_LENGTH) {
+			if (checkSyncByte(buffer.ptr(), CHECK_PACKET_NUM)) {
+				syncOK = true;
+				outPackets();
+			}
+			else {
+				syncOK = false;
+				buffer.trimHead(1);
+			}
+		}
+	}
+
+protected:
+	virtual void onTsPacket(TsPacket packet) = 0;
+
+private:
+	AutoBuffer buffer;
+	bool syncOK;
+
+	bool checkSyncByte(uint8_t* ptr, int numPacket) {
+		for (int i = 0; i < numPacket; ++i) {
+			if (ptr[TS_PACKET_LENGTH*i] != TS_SYNC_BYTE) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void outPackets() {
+		while (buffer.size() >= 2 * TS_PACKET_LENGTH &&
+			checkSyncByte(buffer.ptr(), 2))
+		{
+			TsPacket packet(buffer.ptr());
+			if (packet.parse() && packet.check()) {
+				onTsPacket(packet);
+			}
+			buffer.trimHead(TS_PACKET_LENGTH);
+		}
+	}
+};
+
+struct TsPacketCounter {
+	int64_t numPackets = 0;
+	int64_t hash = 0;
+	void add(TsPacket& packet) {
+		++numPackets;
+		hash = hash * 31 + packet.PID() * 16 + packet.continuity_counter();
+	}
+};
+
+// TsPacketParser̃X[vbgȑO̎Ɣr
+// -a œ̓TCY(GB)w [0.25]
+static int TsPacketParserPerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	class NewParser : public TsPacketParser {
+	public:
+		NewParser(AMTContext& ctx) : TsPacketParser(ctx) { }
+		TsPacketCounter counter;
+	protected:
+		virtual void onTsPacket(TsPacket packet) { counter.add(packet); }
+	};
+	class RefParser : public ReferenceTsPacketParser {
+	public:
+		TsPacketCounter counter;
+	protected:
+		virtual void onTsPacket(TsPacket packet) { counter.add(packet); }
+	};
+
+	int64_t totalBytes = (int64_t)256 * 1024 * 1024;
+	if (setting.getModeArgs().size() > 0) {
+		totalBytes = (int64_t)(std::stod(setting.getModeArgs()) * 1024 * 1024 * 1024);
+	}
+
+	// TSiƂǂɃS~čēj
+	srand(0);
+	std::vector<uint8_t> src;
+	src.reserve(64 * 1024 * 1024 + 1024 * 1024);
+	for (int i = 0; src.size() < 64 * 1024 * 1024; ++i) {
+		size_t offset = src.size();
+		src.resize(offset + TS_PACKET_LENGTH);
+		uint8_t* p = &src[offset];
+		int pid = 0x100 + (i % 16);
+		p[0] = TS_SYNC_BYTE;
+		p[1] = (pid >> 8) & 0x1F;
+		p[2] = pid & 0xFF;
+		p[3] = 0x10 | (i & 0x0F);
+		for (int b = 4; b < TS_PACKET_LENGTH; ++b) {
+			p[b] = rand() & 0xFF;
+		}
+		if (rand() % 10000 == 0) {
+			int garbage = rand() % 200 + 1;
+			for (int b = 0; b < garbage; ++b) {
+				src.push_back(rand() & 0xFF);
+			}
+		}
+	}
+
+	// 1`1000oCg̃_ȋ؂œ͂ĂȑO̎Əo͂v邩
+	{
+		NewParser newParser(ctx);
+		RefParser refParser;
+		size_t checkBytes = std::min<size_t>(src.size(), 8 * 1024 * 1024);
+		for (size_t offset = 0; offset < checkBytes; ) {
+			size_t len = std::min<size_t>(rand() % 1000 + 1, checkBytes - offset);
+			newParser.inputTS(MemoryChunk(&src[offset], len));
+			refParser.inputTS(MemoryChunk(&src[offset], len));
+			offset += len;
+		}
+		if (newParser.counter.numPackets != refParser.counter.numPackets ||
+			newParser.counter.hash != refParser.counter.hash)
+		{
+			THROWF(TestException, "ׂ؂ē͂ƂTsPacketParseȑo͂v܂i%lld/%lldpPbgj",
+				newParser.counter.numPackets, refParser.counter.numPackets);
+		}
+		ctx.infoF("_ȋ؂ł̓: %lldpPbgv", newParser.counter.numPackets);
+	}
+
+	// 4MBPʂœ́ipPbgEƂ͈vȂj
+	enum { CHUNK = 4 * 1024 * 1024 };
+	auto feed = [&](std::function<void(MemoryChunk)> input) {
+		int64_t fed = 0;
+		while (fed < totalBytes) {
+			for (size_t offset = 0; offset < src.size() && fed < totalBytes; offset += CHUNK) {
+				size_t len = std::min<size_t>(CHUNK, src.size() - offset);
+				input(MemoryChunk(&src[offset], len));
+				fed += len;
+			}
+		}
+	};
+
+	Stopwatch sw;
+	NewParser newParser(ctx);
+	sw.start();
+	feed([&](MemoryChunk mc) { newParser.inputTS(mc); });
+	double newTime = sw.getAndReset();
+
+	RefParser refParser;
+	sw.start();
+	feed([&](MemoryChunk mc) { refParser.inputTS(mc); });
+	double refTime = sw.getAndReset();
+
+	double totalMB = (double)totalBytes / (1024 * 1024);
+	printf("New: %.2f sec (%.1f MB/s) %lld packets\n",
+		newTime, totalMB / newTime, newParser.counter.numPackets);
+	printf("Ref: %.2f sec (%.1f MB/s) %lld packets\n",
+		refTime, totalMB / refTime, refParser.counter.numPackets);
+
+	if (newParser.counter.numPackets != refParser.counter.numPackets ||
+		newParser.counter.hash != refParser.counter.hash)
+	{
+		THROW(TestException, "TsPacketParseȑo͂v܂");
+	}
+
+	return 0;
+}
+
+// TsPacketParser192/204oCgԊuTSƃpPbgԊu̕ωɑΉł邩`FbN
+// ͂ǂŋ؂Ăo͂188oCgpPbgƊSɈv邱
+static int TsPacketParserStrideTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	class TestParser : public TsPacketParser {
+	public:
+		TestParser(AMTContext& ctx) : TsPacketParser(ctx) { }
+		std::vector<uint8_t> out;
+	protected:
+		virtual void onTsPacket(TsPacket packet) {
+			out.insert(out.end(), packet.data, packet.data + TS_PACKET_LENGTH);
+		}
+	};
+
+	srand(0);
+	// oCgȊO0x47Ȃ悤ɂiRČʂςȂ悤Ɂj
+	auto randByte = []() {
+		uint8_t b = rand() & 0xFF;
+		return (b == TS_SYNC_BYTE) ? (uint8_t)(b - 1) : b;
+	};
+
+	// packetsɌ188oCgpPbgAstreamstrideԊuŕׂ̂ǉ
+	int numPackets = 0;
+	auto addPackets = [&](std::vector<uint8_t>& packets, std::vector<uint8_t>& stream, int stride, int num) {
+		for (int i = 0; i < num; ++i, ++numPackets) {
+			uint8_t p[TS_PACKET_LENGTH];
+			int pid = 0x100 + (numPackets % 16);
+			p[0] = TS_SYNC_BYTE;
+			p[1] = (pid >> 8) & 0x1F;
+			p[2] = pid & 0xFF;
+			p[3] = 0x10 | (numPackets & 0x0F);
+			for (int b = 4; b < TS_PACKET_LENGTH; ++b) {
+				p[b] = randByte();
+			}
+			packets.insert(packets.end(), p, p + TS_PACKET_LENGTH);
+			if (stride == TS_PACKET_LENGTH2) {
+				// M2TS͑O4oCg̃^CX^v
+				for (int b = 0; b < 4; ++b) stream.push_back(randByte());
+			}
+			stream.insert(stream.end(), p, p + TS_PACKET_LENGTH);
+			if (stride == TS_PACKET_LENGTH3) {
+				// 16oCg̃[h\
+				for (int b = 0; b < 16; ++b) stream.push_back(randByte());
+			}
+		}
+	};
+
+	// 192204̋E͂ǂ̊ԊułȂ̂ŒÕpPbg
+	// ipPbg𗎂ƂɍςޕωeXgj
+	std::vector<std::vector<int>> cases = {
+		{ TS_PACKET_LENGTH },
+		{ TS_PACKET_LENGTH2 },
+		{ TS_PACKET_LENGTH3 },
+		{ TS_PACKET_LENGTH, TS_PACKET_LENGTH2, TS_PACKET_LENGTH, TS_PACKET_LENGTH3, TS_PACKET_LENGTH },
+		{ TS_PACKET_LENGTH3, TS_PACKET_LENGTH, TS_PACKET_LENGTH2 },
+	};
+
+	// ͂̋؂iSĐǂ݃TCY菬pPbg̓rŋ؂j
+	std::vector<int> chunkSizes = { 1, 7, 187, 189, 191, 193, 203, 205, 1000, 1631 };
+
+	for (const auto& strides : cases) {
+		std::vector<uint8_t> packets, stream;
+		std::string name;
+		for (int stride : strides) {
+			addPackets(packets, stream, stride, 50);
+			name += StringFormat("%s%d", name.size() ? "->" : "", stride);
+		}
+
+		// chunkSize=0̓_i1`1000oCgj
+		for (int c = 0; c <= (int)chunkSizes.size(); ++c) {
+			int chunkSize = (c < (int)chunkSizes.size()) ? chunkSizes[c] : 0;
+			TestParser parser(ctx);
+			for (size_t offset = 0; offset < stream.size(); ) {
+				size_t len = (chunkSize > 0) ? chunkSize : (rand() % 1000 + 1);
+				len = std::min(len, stream.size() - offset);
+				parser.inputTS(MemoryChunk(&stream[offset], len));
+				offset += len;
+			}
+			parser.flush();
+
+			if (parser.out != packets) {
+				THROWF(TestException, "TsPacketParseȑo͂v܂ipPbgԊu: %s ؂: %d o: %d/%dpPbgj",
+					name, chunkSize, (int)(parser.out.size() / TS_PACKET_LENGTH), (int)(packets.size() / TS_PACKET_LENGTH));
+			}
+			if (parser.getPacketStride() != strides.back()) {
+				THROWF(TestException, "TsPacketParser̃pPbgԊuႢ܂ipPbgԊu: %s ؂: %d o: %dj",
+					name, chunkSize, parser.getPacketStride());
+			}
+		}
+		ctx.infoF("pPbgԊu %s OK", name);
+	}
+
+	return 0;
+}
+
+// S̓J[l̊eSIMDCƈv邩`FbN
+// ȑOAMTEraseLogo::Delogo
+// rp
+template <typename pixel_t>
+static void ReferenceDelogo(pixel_t* dst, int w, int h, int logopitch, int imgpitch, float maxv, const float* A, const float* B, float fade)
+{
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			float srcv = dst[x + y * imgpitch];
+			float a = A[x + y * logopitch];
+			float b = B[x + y * logopitch];
+			float bg = a * srcv + b * maxv;
+			float tmp = fade * bg + (1 - fade) * srcv;
+			dst[x + y * imgpitch] = (pixel_t)std::min(std::max(tmp + 0.5f, 0.0f), maxv);
+		}
+	}
+}
+
+static int LogoKernelTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const LogoKernelSet& ref = GetLogoKernelC();
+	std::vector<const LogoKernelSet*> kernels = { &GetLogoKernelSSE2() };
+	if (IsAVX2Available()) {
+		kernels.push_back(&GetLogoKernelAVX2());
+	}
+	else {
+		ctx.info("AVX2͗płȂ̂ŃXLbv܂");
+	}
+	if (IsAVX512Available()) {
+		kernels.push_back(&GetLogoKernelAVX512());
+	}
+	else {
+		ctx.info("AVX-512͗płȂ̂ŃXLbv܂");
+	}
+
+	// ͂ǂSIMDł؂ȂTCYɂĒ[̏`FbN
+	const int w = 203, h = 61, pitch = 224;
+	const int numPoints = 1003;
+	const int kstride = (numPoints + LOGO_KERNEL_ALIGN - 1) / LOGO_KERNEL_ALIGN * LOGO_KERNEL_ALIGN;
+
+	srand(0);
+	auto frand = [](float minv, float maxv) {
+		return minv + (maxv - minv) * rand() / RAND_MAX;
+	};
+	std::vector<uint8_t> src8(pitch * h);
+	std::vector<uint16_t> src16(pitch * h);
+	for (int i = 0; i < pitch * h; ++i) {
+		src8[i] = rand() & 0xFF;
+		src16[i] = rand() & 0x3FF;
+	}
+	std::vector<float> srcF(w * 2 * h), A(w * h), B(w * h), Y(w * h);
+	for (auto& v : srcF) v = frand(0, 255);
+	for (auto& v : A) v = frand(0.5f, 1.5f);
+	for (auto& v : B) v = frand(-0.2f, 0.2f);
+	for (auto& v : Y) v = frand(0, 255);
+	// RȂƂĂ
+	std::fill_n(Y.begin() + w * 20, w * 4, 128.0f);
+	std::vector<int> offsets(kstride);
+	for (int i = 0; i < numPoints; ++i) {
+		offsets[i] = (2 + rand() % (w - 4)) + (2 + rand() % (h - 4)) * w;
+	}
+	std::vector<float> kernelsT(LOGO_KERNEL_KLEN * kstride);
+	for (auto& v : kernelsT) v = frand(-1, 1);
+	std::vector<float> scales(numPoints * LOGO_KERNEL_CLEN * 2);
+	for (auto& v : scales) v = frand(0, 0.05f);
+
+	auto check = [&](const char* kernelName, const char* name, const std::vector<float>& expected, const std::vector<float>& actual) {
+		if (memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)) != 0) {
+			THROWF(TestException, "%s: %sCƈv܂", kernelName, name);
+		}
+	};
+
+	// LogoScoreFadesRemoveLogo+LogoScoreƉZႤ̂Ō덷e
+	const int numFades = 11;
+	float fades[numFades];
+	for (int f = 0; f < numFades; ++f) {
+		fades[f] = (float)f / 10.0f;
+	}
+	auto checkFades = [&](const LogoKernelSet* k) {
+		std::vector<float> work(w * h);
+		for (int srcStride : { w, w * 2 }) {
+			float result[numFades];
+			k->LogoScoreFades(result, fades, numFades, srcF.data(), srcStride, A.data(), B.data(), 255.0f, w,
+				offsets.data(), kernelsT.data(), kstride, scales.data(), numPoints);
+			for (int f = 0; f < numFades; ++f) {
+				ref.RemoveLogo(work.data(), srcF.data(), srcStride, A.data(), B.data(), w, h, 255.0f, fades[f]);
+				float e = ref.LogoScore(work.data(), w, offsets.data(), kernelsT.data(), kstride, scales.data(), numPoints);
+				if (std::abs(e - result[f]) > 1e-5f * numPoints) {
+					THROWF(TestException, "%s: LogoScoreFades(fade=%.1f)RemoveLogo+LogoScoreƈv܂(%f != %f)",
+						k->name, fades[f], result[f], e);
+				}
+			}
+		}
+	};
+	checkFades(&ref);
+
+	// Delogo͈ȑO̎ƊSɈv邱
+	// t[ƃtB[hi1Cj̗
+	// B͑傫߂ɂăNvf
+	std::vector<float> delogoB(w * h);
+	for (auto& v : delogoB) v = frand(-0.6f, 0.3f);
+	auto checkDelogo = [&](const LogoKernelSet* k, bool reference) {
+		for (float fade : { 0.0f, 0.3f, 1.0f }) {
+			for (int field = 0; field < 2; ++field) {
+				int dh = field ? h / 2 : h;
+				int logoPitch = field ? w * 2 : w;
+				int imgPitch = field ? pitch * 2 : pitch;
+				std::vector<uint8_t> expected8 = src8, actual8 = src8;
+				std::vector<uint16_t> expected16 = src16, actual16 = src16;
+				if (reference) {
+					ReferenceDelogo(expected8.data(), w, dh, logoPitch, imgPitch, 255.0f, A.data(), delogoB.data(), fade);
+					ReferenceDelogo(expected16.data(), w, dh, logoPitch, imgPitch, 1023.0f, A.data(), delogoB.data(), fade);
+				}
+				else {
+					ref.Delogo8(expected8.data(), w, dh, logoPitch, imgPitch, 255.0f, A.data(), delogoB.data(), fade);
+					ref.Delogo16(expected16.data(), w, dh, logoPitch, imgPitch, 1023.0f, A.data(), delogoB.data(), fade);
+				}
+				k->Delogo8(actual8.data(), w, dh, logoPitch, imgPitch, 255.0f, A.data(), delogoB.data(), fade);
+				k->Delogo16(actual16.data(), w, dh, logoPitch, imgPitch, 1023.0f, A.data(), delogoB.data(), fade);
+				if (expected8 != actual8) {
+					THROWF(TestException, "%s: Delogo8%sƈv܂", k->name, reference ? "ȑO̎" : "C");
+				}
+				if (expected16 != actual16) {
+					THROWF(TestException, "%s: Delogo16%sƈv܂", k->name, reference ? "ȑO̎" : "C");
+				}
+			}
+		}
+	};
+	checkDelogo(&ref, true);
+
+	std::vector<float> expected(w * h), actual(w * h);
+	std::vector<float> expectedWork(w * h), actualWork(w * h);
+	for (auto k : kernels) {
+		ref.DeintY8(expected.data(), src8.data(), pitch, w, h);
+		k->DeintY8(actual.data(), src8.data(), pitch, w, h);
+		check(k->name, "DeintY8", expected, actual);
+
+		ref.DeintY16(expected.data(), src16.data(), pitch, w, h);
+		k->DeintY16(actual.data(), src16.data(), pitch, w, h);
+		check(k->name, "DeintY16", expected, actual);
+
+		for (float fade : { 0.0f, 0.3f, 1.0f }) {
+			ref.RemoveLogo(expected.data(), srcF.data(), w * 2, A.data(), B.data(), w, h, 255.0f, fade);
+			k->RemoveLogo(actual.data(), srcF.data(), w * 2, A.data(), B.data(), w, h, 255.0f, fade);
+			check(k->name, "RemoveLogo", expected, actual);
+		}
+
+		std::fill(expected.begin(), expected.end(), 0.0f);
+		std::fill(actual.begin(), actual.end(), 0.0f);
+		ref.Variance5x5(expected.data(), Y.data(), w, h);
+		k->Variance5x5(actual.data(), Y.data(), w, h);
+		check(k->name, "Variance5x5", expected, actual);
+
+		ref.MaxFilter3(Y.data(), expectedWork.data(), w, h);
+		k->MaxFilter3(Y.data(), actualWork.data(), w, h);
+		check(k->name, "MaxFilter3", expectedWork, actualWork);
+
+		// ړ_Ƃ̒l͈v邪Av̏Ⴄ̂Ō덷e
+		float e = ref.LogoScore(Y.data(), w, offsets.data(), kernelsT.data(), kstride, scales.data(), numPoints);
+		float a = k->LogoScore(Y.data(), w, offsets.data(), kernelsT.data(), kstride, scales.data(), numPoints);
+		if (std::abs(e - a) > 1e-5f * numPoints) {
+			THROWF(TestException, "%s: LogoScoreCƈv܂(%f != %f)", k->name, a, e);
+		}
+
+		checkFades(k);
+		checkDelogo(k, false);
+
+		ctx.infoF("%s: OK", k->name);
+	}
+
+	return 0;
+}
+
+// ƂɑE\[gĂȑOLogoFrame::writeResult̃tB^
+// rp
+static void ReferenceSmoothLogoScores(const float* rawScores, int numFrames,
+	int halfAvgFrames, int halfMedianFrames, float threshL, float thresh, logo::LogoFrameResult* frameResult)
+{
+	int aveFrames = halfAvgFrames * 2 + 1;
+	int medianFrames = halfMedianFrames * 2 + 1;
+	std::vector<float> medianBuf(medianFrames);
+	for (int i = 0; i < numFrames; ++i) {
+		float beforeMax = *std::max_element(rawScores + i - halfAvgFrames, rawScores + i);
+		float afterMax = *std::max_element(rawScores + i + 1, rawScores + i + 1 + halfAvgFrames);
+		float minMax = std::min(beforeMax, afterMax);
+		int minMaxResult = (std::abs(minMax) < threshL) ? 1 : (minMax < 0.0f) ? 0 : 2;
+
+		float avg = std::accumulate(rawScores + i - halfAvgFrames,
+			rawScores + i + halfAvgFrames + 1, 0.0f) / aveFrames;
+		int avgResult = (std::abs(avg) < thresh) ? 1 : (avg < 0.0f) ? 0 : 2;
+
+		frameResult[i].result = (minMaxResult != avgResult) ? 1 : minMaxResult;
+
+		std::copy(rawScores + i - halfMedianFrames,
+			rawScores + i + halfMedianFrames + 1, medianBuf.begin());
+		std::sort(medianBuf.begin(), medianBuf.end());
+		frameResult[i].score = medianBuf[halfMedianFrames];
+	}
+}
+
+// LogoFrame::writeResult̃tB^̑xȑO̎Ɣr
+// 360fpsz
+static int LogoFrameFilterPerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const int framesPerSec = 60;
+	const int numFrames = framesPerSec * 60 * 60 * 3;
+	// writeResultƓp[^
+	const float threshL = 0.5f;
+	const float thresh = 0.2f;
+	int halfAvgFrames = int(framesPerSec * 1.0f / 2 + 0.5f);
+	int halfMedianFrames = int(framesPerSec * 0.5f / 2 + 0.5f);
+	int halfWinFrames = std::max(halfAvgFrames, halfMedianFrames);
+
+	// SEȂ̋ԂɃmCY悹XRA
+	srand(0);
+	std::vector<float> rawScores_(numFrames + halfWinFrames * 2 + 1);
+	float* rawScores = rawScores_.data() + halfWinFrames;
+	float level = 0.6f;
+	for (int i = 0; i < numFrames; ++i) {
+		if (rand() % 3000 == 0) {
+			int r = rand() % 3;
+			level = (r == 0) ? -0.6f : (r == 1) ? 0.6f : 0.2f;
+		}
+		rawScores[i] = level + (rand() / (float)RAND_MAX - 0.5f) * 1.2f;
+		// 臒l傤ǂ̒lĂ
+		if (rand() % 500 == 0) {
+			rawScores[i] = (rand() % 2) ? thresh : -thresh;
+		}
+	}
+	std::fill(rawScores_.begin(), rawScores_.begin() + halfWinFrames, rawScores[0]);
+	std::fill(rawScores + numFrames, rawScores_.data() + rawScores_.size(), rawScores[numFrames - 1]);
+
+	std::vector<logo::LogoFrameResult> expected(numFrames), actual(numFrames);
+
+	Stopwatch sw;
+	sw.start();
+	ReferenceSmoothLogoScores(rawScores, numFrames, halfAvgFrames, halfMedianFrames, threshL, thresh, expected.data());
+	double refTime = sw.getAndReset();
+
+	sw.start();
+	logo::SmoothLogoScores(rawScores, numFrames, halfAvgFrames, halfMedianFrames, threshL, thresh, actual.data());
+	double newTime = sw.getAndReset();
+
+	printf("Ref: %.3f sec\n", refTime);
+	printf("New: %.3f sec\n", newTime);
+
+	for (int i = 0; i < numFrames; ++i) {
+		if (expected[i].result != actual[i].result || expected[i].score != actual[i].score) {
+			THROWF(TestException, "t[%ďʂv܂", i);
+		}
+	}
+
+	return 0;
+}
+
+// DataPumpThreadSPSCDataPumpThread̃t[󂯓n̔r
+// 4Kt[i̎QƁj60fpsŎ󂯓nƂ̒x
+// S͂Ŏ󂯓nƂ̃X[vbgECPUԂ𑪂
+struct DataPumpTestFrame {
+	std::shared_ptr<std::vector<uint8_t>> buf;
+	int64_t putTime;
+};
+
+struct DataPumpTestStat {
+	int64_t numFrames;
+	int64_t checksum;
+	double latencySum;
+	double latencyMax;
+
+	void add(const DataPumpTestFrame& frame) {
+		if (frame.buf) {
+			int64_t cur; QueryPerformanceCounter((LARGE_INTEGER*)&cur);
+			int64_t freq; QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
+			double latency = (double)(cur - frame.putTime) / freq;
+			latencySum += latency;
+			latencyMax = std::max(latencyMax, latency);
+			checksum += (*frame.buf)[(size_t)(numFrames % frame.buf->size())];
+			++numFrames;
+		}
+	}
+};
+
+static double GetProcessCPUTime() {
+	FILETIME creation, exit, kernel, user;
+	GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+	auto toSec = [](FILETIME ft) { return (((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime) * 1e-7; };
+	return toSec(kernel) + toSec(user);
+}
+
+template <typename Pump>
+static int64_t RunDataPumpPerf(Pump& pump, const char* name, int numFrames, bool paced,
+	const std::vector<std::shared_ptr<std::vector<uint8_t>>>& frames)
+{
+	int64_t freq; QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
+	int64_t begin; QueryPerformanceCounter((LARGE_INTEGER*)&begin);
+	double cpuBegin = GetProcessCPUTime();
+	Stopwatch sw;
+	sw.start();
+	pump.start();
+	for (int i = 0; i < numFrames; ++i) {
+		if (paced) {
+			// 60fpsŃt[oĂ
+			int64_t due = begin + freq * i / 60;
+			while (true) {
+				int64_t cur; QueryPerformanceCounter((LARGE_INTEGER*)&cur);
+				if (cur >= due) break;
+				Sleep((DWORD)std::max<int64_t>(0, (due - cur) * 1000 / freq - 1));
+			}
+		}
+		DataPumpTestFrame frame = { frames[i % frames.size()] };
+		QueryPerformanceCounter((LARGE_INTEGER*)&frame.putTime);
+		pump.put(std::move(frame));
+	}
+	pump.join();
+	double total = sw.getAndReset();
+	double cpu = GetProcessCPUTime() - cpuBegin;
+	double prod, cons; pump.getTotalWait(prod, cons);
+	const auto& stat = pump.stat;
+	printf("%s: %d frames %.3f sec (%.0f fps) CPU %.3f sec (%.2f us/frame) "
+		"latency avg %.3f ms max %.3f ms ProducerWait: %.3f sec ConsumerWait: %.3f sec\n",
+		name, numFrames, total, numFrames / total, cpu, cpu * 1e6 / numFrames,
+		stat.latencySum * 1000 / stat.numFrames, stat.latencyMax * 1000, prod, cons);
+	if (stat.numFrames != numFrames) {
+		THROWF(TestException, "%s: t[܂(%lld/%d)", name, stat.numFrames, numFrames);
+	}
+	return stat.checksum;
+}
+
+static int DataPumpPerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	// ܂Œʂq[vɊmۂt[n
+	class MutexPump : public DataPumpThread<std::unique_ptr<DataPumpTestFrame>, true> {
+	public:
+		MutexPump(int bufferingFrames) : DataPumpThread(bufferingFrames), stat() { }
+		DataPumpTestStat stat;
+		void put(DataPumpTestFrame&& frame) {
+			DataPumpThread::put(std::unique_ptr<DataPumpTestFrame>(new DataPumpTestFrame(std::move(frame))), 1);
+		}
+	protected:
+		virtual void OnDataReceived(std::unique_ptr<DataPumpTestFrame>&& data) { stat.add(*data); }
+	};
+	class SPSCPump : public SPSCDataPumpThread<DataPumpTestFrame, true> {
+	public:
+		SPSCPump(int bufferingFrames) : SPSCDataPumpThread(bufferingFrames), stat() { }
+		DataPumpTestStat stat;
+		void put(DataPumpTestFrame&& frame) { SPSCDataPumpThread::put(std::move(frame), 1); }
+	protected:
+		virtual void OnDataReceived(DataPumpTestFrame&& data) { stat.add(data); }
+	};
+
+	// 4K YUV420 8bit
+	const size_t frameBytes = 3840 * 2160 * 3 / 2;
+	const int bufferingFrames = 16; // --encode-buffer̃ftHg
+	std::vector<std::shared_ptr<std::vector<uint8_t>>> frames;
+	for (int i = 0; i < 4; ++i) {
+		frames.emplace_back(new std::vector<uint8_t>(frameBytes, (uint8_t)i));
+	}
+
+	// 60fps 10b
+	{
+		const int numFrames = 600;
+		MutexPump mutexPump(bufferingFrames);
+		SPSCPump spscPump(bufferingFrames);
+		printf("[60fps]\n");
+		int64_t a = RunDataPumpPerf(mutexPump, "Mutex", numFrames, true, frames);
+		int64_t b = RunDataPumpPerf(spscPump, "SPSC", numFrames, true, frames);
+		if (a != b) {
+			THROW(TestException, "󂯓nf[^v܂");
+		}
+	}
+	// S
+	{
+		const int numFrames = 1000000;
+		MutexPump mutexPump(bufferingFrames);
+		SPSCPump spscPump(bufferingFrames);
+		printf("[Max throughput]\n");
+		int64_t a = RunDataPumpPerf(mutexPump, "Mutex", numFrames, false, frames);
+		int64_t b = RunDataPumpPerf(spscPump, "SPSC", numFrames, false, frames);
+		if (a != b) {
+			THROW(TestException, "󂯓nf[^v܂");
+		}
+	}
+
+	return 0;
+}
+
+// SoCg1oCgRs[ăG~[Vh~oCgĂȑOH264VideoParser
+// rp
+class ReferenceH264VideoParser : public H264VideoParser {
+public:
+	ReferenceH264VideoParser(AMTContext& ctx) : H264VideoParser(ctx) { }
+
+protected:
+	virtual void storeBuffer(MemoryChunk frame) {
+		buffer.clear();
+		nalUnits.clear();
+		buffer.add(MemoryChunk(frame.data, 2));
+		int32_t n3bytes = (frame.data[0] << 8) | frame.data[1];
+		int unitStart = 0;
+		int lastNonZero = 0;
+		for (int i = 2; i < (int)frame.length; ++i) {
+			uint8_t inByte = frame.data[i];
+			n3bytes = ((n3bytes & 0xFFFF) << 8) | inByte;
+			if (n3bytes == 0x03) {
+				// skip one byte
+			}
+			else {
+				buffer.add(inByte);
+				int k = (int)buffer.size();
+
+				if (n3bytes == 0x01) {
+					// start code prefix
+					pushNalUnit(unitStart, lastNonZero);
+					unitStart = k;
+				}
+				if (inByte) {
+					lastNonZero = k;
+				}
+			}
+		}
+		pushNalUnit(unitStart, lastNonZero);
+	}
+
+private:
+	void pushNalUnit(int unitStart, int lastNonZero) {
+		if (lastNonZero > 0) {
+			NalUnit nal;
+			nal.offset = unitStart;
+			// rbsp_stop_one_bit菜
+			uint8_t& lastByte = buffer.ptr()[lastNonZero - 1];
+			if (lastByte == 0x80) {
+				// yC[h͂̃oCgɂ͂Ȃ̂1oCg
+				--lastNonZero;
+			}
+			else {
+				lastByte &= lastByte - 1;
+			}
+			nal.length = lastNonZero - unitStart;
+			nal.header = (nal.length > 0) ? buffer.ptr()[unitStart] : 0;
+			nalUnits.push_back(nal);
+		}
+	}
+};
+
+// TSfPES̃yC[hW߂
+class VideoPesCollector : public TsPacketParser {
+public:
+	struct Payload {
+		std::vector<uint8_t> data;
+		int64_t PTS, DTS;
+	};
+
+	VideoPesCollector(AMTContext& ctx) : TsPacketParser(ctx) { }
+
+	// ԃf[^̑fPID
+	const std::vector<Payload>& getVideo() {
+		const std::vector<Payload>* ret = nullptr;
+		size_t maxBytes = 0;
+		for (auto& pair : pids) {
+			if (pair.second->totalBytes > maxBytes) {
+				maxBytes = pair.second->totalBytes;
+				ret = &pair.second->payloads;
+			}
+		}
+		if (ret == nullptr) {
+			THROW(TestException, "f܂");
+		}
+		return *ret;
+	}
+
+protected:
+	virtual void onTsPacket(TsPacket packet) {
+		auto& parser = pids[packet.PID()];
+		if (parser == nullptr) {
+			parser = std::unique_ptr<PidParser>(new PidParser());
+		}
+		parser->onTsPacket(-1, packet);
+	}
+
+private:
+	class PidParser : public PesParser {
+	public:
+		PidParser() : totalBytes(0) { }
+		std::vector<Payload> payloads;
+		size_t totalBytes;
+	protected:
+		virtual void onPesPacket(int64_t clock, PESPacket packet) {
+			if ((packet.stream_id() & 0xF0) != 0xE0 || !packet.has_PTS()) {
+				// fłȂ
+				return;
+			}
+			MemoryChunk payload = packet.paylod();
+			Payload p;
+			p.data.assign(payload.data, payload.data + payload.length);
+			p.PTS = packet.PTS;
+			p.DTS = packet.has_DTS() ? packet.DTS : packet.PTS;
+			totalBytes += payload.length;
+			payloads.push_back(std::move(p));
+		}
+	};
+
+	std::map<int, std::unique_ptr<PidParser>> pids;
+};
+
+static double RunH264Parser(H264VideoParser& parser,
+	const std::vector<VideoPesCollector::Payload>& payloads, int numLoops,
+	std::vector<VideoFrameInfo>& out, int& numFailed)
+{
+	std::vector<VideoFrameInfo> info;
+	Stopwatch sw;
+	sw.start();
+	for (int loop = 0; loop < numLoops; ++loop) {
+		parser.reset();
+		out.clear();
+		numFailed = 0;
+		for (const auto& p : payloads) {
+			MemoryChunk mc((uint8_t*)p.data.data(), p.data.size());
+			if (!parser.inputFrame(mc, info, p.PTS, p.DTS)) {
+				++numFailed;
+			}
+			out.insert(out.end(), info.begin(), info.end());
+		}
+	}
+	return sw.getAndReset();
+}
+
+// H264VideoParseȑԂȑO̎Ɣr
+// ͂H.264TSi擪ő512MBgj
+static int H264ParserPerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	int numLoops = 10;
+	if (setting.getModeArgs().size() > 0) {
+		numLoops = std::stoi(setting.getModeArgs());
+	}
+
+	VideoPesCollector collector(ctx);
+	{
+		enum { CHUNK = 4 * 1024 * 1024 };
+		File srcfile(setting.getSrcFilePath(), _T("rb"));
+		std::vector<uint8_t> buf(CHUNK);
+		for (int64_t total = 0; total < (int64_t)512 * 1024 * 1024; ) {
+			size_t readBytes = srcfile.read(MemoryChunk(buf.data(), buf.size()));
+			if (readBytes == 0) {
+				break;
+			}
+			collector.inputTS(MemoryChunk(buf.data(), readBytes));
+			total += readBytes;
+		}
+	}
+	const auto& payloads = collector.getVideo();
+	size_t totalBytes = 0;
+	for (const auto& p : payloads) {
+		totalBytes += p.data.size();
+	}
+
+	std::vector<VideoFrameInfo> newInfo, refInfo;
+	int newFailed, refFailed;
+	H264VideoParser newParser(ctx);
+	double newTime = RunH264Parser(newParser, payloads, numLoops, newInfo, newFailed);
+	ReferenceH264VideoParser refParser(ctx);
+	double refTime = RunH264Parser(refParser, payloads, numLoops, refInfo, refFailed);
+
+	double totalMB = (double)totalBytes * numLoops / (1024 * 1024);
+	printf("%d PES packets %.1f MB x %d\n", (int)payloads.size(), totalBytes / (1024.0 * 1024.0), numLoops);
+	printf("New: %.2f sec (%.1f MB/s) %d frames\n", newTime, totalMB / newTime, (int)newInfo.size());
+	printf("Ref: %.2f sec (%.1f MB/s) %d frames\n", refTime, totalMB / refTime, (int)refInfo.size());
+
+	if (newInfo.size() == 0) {
+		THROW(TestException, "H.264̃t[܂");
+	}
+	if (newFailed != refFailed || newInfo.size() != refInfo.size()) {
+		THROW(TestException, "H264VideoParseȑo͂v܂");
+	}
+	for (int i = 0; i < (int)newInfo.size(); ++i) {
+		const VideoFrameInfo& a = newInfo[i];
+		const VideoFrameInfo& b = refInfo[i];
+		if (a.PTS != b.PTS || a.DTS != b.DTS || a.isGopStart != b.isGopStart ||
+			a.pic != b.pic || a.type != b.type || a.codedDataSize != b.codedDataSize ||
+			a.format != b.format)
+		{
+			THROW(TestException, "H264VideoParseȑo͂v܂");
+		}
+	}
+
+	return 0;
+}
+
+// rp̈ȑOMakeVFRBitrateZones
+// ÂтɃubN̑S͈͂𑖍ăRXgvZ
+static std::vector<BitrateZone> ReferenceMakeVFRBitrateZones(const std::vector<double>& timeCodes,
+	const std::vector<EncoderZone>& cmzones, double bitrateCM,
+	int fpsNum, int fpsDenom, double timeFactor, double costLimit)
+{
+	enum {
+		UNIT_FRAMES = 8,
+		HARD_ZONE_LIMIT = 1000, // ][1000
+		TARGET_ZONES_PER_HOUR = 30 // ڕW][1Ԃ30
+	};
+	struct Block {
+		int index;   // ubN擪UNITAhX
+		int next;    // ̃ubN̐擪ubNAhXĩubN݂Ȃꍇ-1j
+		double avg;  // ̃ubN̕σrbg[g
+		double cost; // ̃ubNƌƂ̒ǉRXg
+	};
+
+	if (timeCodes.size() == 0) {
+		return std::vector<BitrateZone>();
+	}
+	int numFrames = (int)timeCodes.size() - 1;
+	// 8t[Ƃ̕σrbg[gvZ
+	std::vector<double> units(nblocks(numFrames, UNIT_FRAMES));
+	for (int i = 0; i < (int)units.size(); ++i) {
+		auto start = timeCodes.begin() + i * UNIT_FRAMES;
+		auto end = ((i + 1) * UNIT_FRAMES < timeCodes.size()) ? start + UNIT_FRAMES : timeCodes.end() - 1;
+		double sum = (*end - *start) / 1000.0 * fpsNum / fpsDenom;
+		double invfps = sum / (int)(end - start);
+		units[i] = (invfps - 1.0) * timeFactor + 1.0;
+	}
+	// cmzonesKp
+	for (int i = 0; i < (int)cmzones.size(); ++i) {
+		// [CM][Ɋۂ߂
+		int start = nblocks(cmzones[i].startFrame, UNIT_FRAMES);
+		int end = cmzones[i].endFrame / UNIT_FRAMES;
+		for (int k = start; k < end; ++k) {
+			units[k] *= bitrateCM;
+		}
+	}
+	// łunits͊et[ɓKpׂrbg[g
+	// Â܂zonesɂƐ
+	// R}hCɂłȂ̂łx܂Ƃ߂
+	std::vector<Block> blocks;
+	double cur = units[0];
+	blocks.push_back(Block{ 0, 1, cur, 0 });
+	// rbg[g̘A͂܂Ƃ߂
+	for (int i = 1; i < (int)units.size(); ++i) {
+		if (units[i] != cur) {
+			cur = units[i];
+			blocks.push_back(Block{ i, (int)blocks.size() + 1, cur, 0 });
+		}
+	}
+	// Ōɔԕu
+	blocks.push_back(Block{ (int)units.size(), -1, 0, 0 });
+
+	auto sumDiff = [&](int start, int end, double avg) {
+		double diff = 0;
+		for (int i = start; i < end; ++i) {
+			diff += std::abs(units[i] - avg);
+		}
+		return diff;
+	};
+
+	auto calcCost = [&](Block& cur, const Block&  next) {
+		int start = cur.index;
+		int mid = next.index;
+		int end = blocks[next.next].index;
+		// ݂̃RXg
+
+		double cur_cost = sumDiff(start, mid, cur.avg);
+		double next_cost = sumDiff(mid, end, next.avg);
+		// A̕σrbg[g
+		double avg2 = (cur.avg * (mid - start) + next.avg * (end - mid)) / (end - start);
+		// ÃRXg
+		double cost2 = sumDiff(start, end, avg2);
+		// ǉRXg
+		cur.cost = cost2 - (cur_cost + next_cost);
+	};
+
+	// AǉRXgvZ
+	for (int i = 0; blocks[i].index < (int)units.size(); i = blocks[i].next) {
+		auto& cur = blocks[i];
+		auto& next = blocks[cur.next];
+		// ̃ubN݂
+		if (next.index < (int)units.size()) {
+			calcCost(cur, next);
+		}
+	}
+
+	// őubN
+	auto totalHours = timeCodes.back() / 1000.0 / 3600.0;
+	int targetNumZones = std::max(1, (int)(TARGET_ZONES_PER_HOUR * totalHours));
+	double totalCostLimit = units.size() * costLimit;
+
+	// q[v쐬
+	auto comp = [&](int b0, int b1) {
+		return blocks[b0].cost > blocks[b1].cost;
+	};
+	// Ō̃ubNƔԕ͘AłȂ̂ŏ
+	int heapSize = (int)blocks.size() - 2;
+	int numZones = heapSize;
+	std::vector<int> indices(heapSize);
+	for (int i = 0; i < heapSize; ++i) indices[i] = i;
+	std::make_heap(indices.begin(), indices.begin() + heapSize, comp);
+	double totalCost = 0;
+	while ((totalCost < totalCostLimit && numZones > targetNumZones) ||
+		numZones > HARD_ZONE_LIMIT)
+	{
+		// ǉRXgŏubN
+		int idx = indices.front();
+		std::pop_heap(indices.begin(), indices.begin() + (heapSize--), comp);
+		auto& cur = blocks[idx];
+		// ̃ubNɘAς݂łȂ
+		if (cur.next != -1) {
+			auto& next = blocks[cur.next];
+			int start = cur.index;
+			int mid = next.index;
+			int end = blocks[next.next].index;
+			totalCost += cur.cost;
+			// A̕σrbg[gɍXV
+			cur.avg = (cur.avg * (mid - start) + next.avg * (end - mid)) / (end - start);
+			// AnextɍXV
+			cur.next = next.next;
+			// AubN͖
+			next.next = -1;
+			--numZones;
+			// XɎ̃ubN
+			auto& nextnext = blocks[cur.next];
+			if (nextnext.index < (int)units.size()) {
+				// A̒ǉRXgvZ
+				calcCost(cur, nextnext);
+				// ēxq[vɒǉ
+				indices[heapSize] = idx;
+				std::push_heap(indices.begin(), indices.begin() + (++heapSize), comp);
+			}
+		}
+	}
+
+	// ʂ𐶐
+	std::vector<BitrateZone> zones;
+	for (int i = 0; blocks[i].index < (int)units.size(); i = blocks[i].next) {
+		const auto& cur = blocks[i];
+		BitrateZone zone = BitrateZone();
+		zone.startFrame = cur.index * UNIT_FRAMES;
+		zone.endFrame = std::min(numFrames, blocks[cur.next].index * UNIT_FRAMES);
+		zone.bitrate = cur.avg;
+		zones.push_back(zone);
+	}
+
+	return zones;
+}
+
+// 120fps^C~OVFR^CR[h
+// pattern 0: 24p/30p/60p̋Ԃ炵
+// pattern 1: ŒԂ̌ɍׂhԂ́iȑO̎xȂj
+static std::vector<double> MakeBenchTimeCodes(int pattern, double hours, std::vector<EncoderZone>& cmzones)
+{
+	const double tick = 1000.0 * 1001 / 120000;
+	int numFrames = (int)(hours * 3600 * 120 / 4); // 4tick
+	std::vector<double> timeCodes;
+	double elapsed = 0;
+	uint32_t rnd = 1;
+	auto next = [&]() { rnd = rnd * 1103515245 + 12345; return (rnd >> 16) & 0x7FFF; };
+	int mode = 0, left = 0;
+	for (int i = 0; i < numFrames; ++i) {
+		timeCodes.push_back(elapsed);
+		double dur;
+		if (pattern == 0) {
+			if (left == 0) {
+				mode = next() % 4;
+				left = 1 + next() % ((next() % 2) ? 20 : 3000);
+			}
+			--left;
+			switch (mode) {
+			case 0: dur = 4; break; // 30p
+			case 1: dur = (i & 1) ? 4 : 6; break; // 24p
+			case 2: dur = 2; break; // 60p
+			default: dur = 2 + 2 * (next() % 3); break;
+			}
+		}
+		else {
+			int unit = i / 8;
+			dur = (i < numFrames / 2) ? 4 : ((unit & 1) ? 4.04 : 3.96);
+		}
+		elapsed += tick * dur;
+	}
+	timeCodes.push_back(elapsed);
+	cmzones.clear();
+	if (pattern == 0) {
+		for (int f = next() % 5000; f < numFrames - 100; ) {
+			int len = 100 + next() % 3000;
+			cmzones.push_back(EncoderZone{ f, std::min(numFrames, f + len) });
+			f += len + 1000 + next() % 20000;
+		}
+	}
+	return timeCodes;
+}
+
+static int BitrateZonesPerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	double hours = 3;
+	if (setting.getModeArgs().size() > 0) {
+		hours = std::stod(setting.getModeArgs());
+	}
+
+	for (int pattern = 0; pattern < 2; ++pattern) {
+		std::vector<EncoderZone> cmzones;
+		auto timeCodes = MakeBenchTimeCodes(pattern, hours, cmzones);
+		// ŒԂŏ܂ŘA邽߂ɃRXg͑傫
+		double costLimit = (pattern == 0) ? 0.15 : 100;
+
+		Stopwatch sw;
+		sw.start();
+		auto zones = MakeVFRBitrateZones(timeCodes, cmzones, 0.5, 120000, 1001, 1.0, costLimit);
+		double newTime = sw.getAndReset();
+		sw.start();
+		auto refZones = ReferenceMakeVFRBitrateZones(timeCodes, cmzones, 0.5, 120000, 1001, 1.0, costLimit);
+		double refTime = sw.getAndReset();
+
+		printf("[pattern %d] %.1f %d frames -> %d zones\n",
+			pattern, hours, (int)timeCodes.size() - 1, (int)zones.size());
+		printf("New: %.3f sec\n", newTime);
+		printf("Ref: %.3f sec\n", refTime);
+
+		if (zones.size() != refZones.size()) {
+			THROW(TestException, "][v܂");
+		}
+		for (int i = 0; i < (int)zones.size(); ++i) {
+			if (zones[i].startFrame != refZones[i].startFrame ||
+				zones[i].endFrame != refZones[i].endFrame ||
+				zones[i].bitrate != refZones[i].bitrate)
+			{
+				THROW(TestException, "][v܂");
+			}
+		}
+	}
+
+	return 0;
+}
+
+// AMTAnalyzeLogo1t[͎̉Ԃ
+// tF[hlƂEvaluateLogoĂȑO̎Ɣr
+// Sƃt[͍
+static int LogoAnalyzePerf(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const int w = 320, h = 120;
+	const int imgw = 1920, imgh = 1080;
+	const int numFrames = 240;
+	const float maskratio = 0.1f;
+	const float maxv = 255.0f;
+
+	// gt̔S
+	// OiAFc src = (1 - ) * bg +  * c Ȃ̂ bg = A * src + B
+	auto alphaAt = [&](int x, int y) {
+		int dx = std::abs(x - w / 2), dy = std::abs(y - h / 2);
+		bool frame = (dx < w / 2 - 16 && dy < h / 2 - 16) && !(dx < w / 2 - 24 && dy < h / 2 - 24);
+		bool bar = ((x / 12) % 3 == 0) && dy < h / 4;
+		return (frame || bar) ? 0.5f : 0.0f;
+	};
+	const float logoColor = 0.9f;
+	logo::LogoData logodata(w, h, 1, 1);
+	for (int plane : { PLANAR_Y, PLANAR_U, PLANAR_V }) {
+		int pw = (plane == PLANAR_Y) ? w : (w >> 1);
+		int ph = (plane == PLANAR_Y) ? h : (h >> 1);
+		std::fill_n(logodata.GetA(plane), pw * ph, 1.0f);
+		std::fill_n(logodata.GetB(plane), pw * ph, 0.0f);
+	}
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			float alpha = alphaAt(x, y);
+			logodata.GetA(PLANAR_Y)[x + y * w] = 1.0f / (1.0f - alpha);
+			logodata.GetB(PLANAR_Y)[x + y * w] = -alpha * logoColor / (1.0f - alpha);
+		}
+	}
+	logo::LogoDataParam logo(std::move(logodata), imgw, imgh, 0, 0);
+	logo::LogoDataParam deintLogo(logo::LogoData(w, h, 1, 1), imgw, imgh, 0, 0);
+	logo::DeintLogo(deintLogo, logo, w, h);
+	deintLogo.CreateLogoMask(maskratio);
+	auto fieldLogoT = logo.MakeFieldLogo(false);
+	fieldLogoT->CreateLogoMask(maskratio);
+	auto fieldLogoB = logo.MakeFieldLogo(true);
+	fieldLogoB->CreateLogoMask(maskratio);
+
+	// wi͊ɂ₩ȃOf[V{mCYAS̓t[ƂɃtF[hς
+	srand(0);
+	std::vector<std::vector<uint8_t>> frames(numFrames, std::vector<uint8_t>(w * h));
+	for (int i = 0; i < numFrames; ++i) {
+		float fade = (i % 40) / 39.0f;
+		float base = (float)(rand() % 200);
+		for (int y = 0; y < h; ++y) {
+			for (int x = 0; x < w; ++x) {
+				float bg = base + x * 0.1f + y * 0.2f + (rand() % 16);
+				float alpha = alphaAt(x, y) * fade;
+				float v = (1.0f - alpha) * bg + alpha * logoColor * maxv;
+				frames[i][x + y * w] = (uint8_t)std::max(0.0f, std::min(maxv, v + 0.5f));
+			}
+		}
+	}
+
+	std::vector<float> memCopy(w * h + 8), memDeint(w * h + 8), memWork(w * h + 8);
+	std::vector<logo::LogoAnalyzeFrame> expected(numFrames), actual(numFrames);
+
+	Stopwatch sw;
+	sw.start();
+	for (int i = 0; i < numFrames; ++i) {
+		logo::CopyY(memCopy.data(), frames[i].data(), w, w, h);
+		logo::DeintY(memDeint.data(), frames[i].data(), w, w, h);
+		logo::LogoAnalyzeFrame& info = expected[i];
+		for (int f = 0; f <= 10; ++f) {
+			info.p[f] = std::abs(deintLogo.EvaluateLogo(memDeint.data(), maxv, (float)f / 10.0f, memWork.data()));
+			info.t[f] = std::abs(fieldLogoT->EvaluateLogo(memCopy.data(), maxv, (float)f / 10.0f, memWork.data(), w * 2));
+			info.b[f] = std::abs(fieldLogoB->EvaluateLogo(memCopy.data() + w, maxv, (float)f / 10.0f, memWork.data(), w * 2));
+		}
+	}
+	double refTime = sw.getAndReset();
+
+	for (int i = 0; i < numFrames; ++i) {
+		logo::CopyY(memCopy.data(), frames[i].data(), w, w, h);
+		logo::DeintY(memDeint.data(), frames[i].data(), w, w, h);
+		logo::AnalyzeLogoFrame(actual[i], deintLogo, *fieldLogoT, *fieldLogoB, memDeint.data(), memCopy.data(), w, maxv);
+	}
+	double newTime = sw.getAndReset();
+
+	printf("Ref: %.3f ms/frame\n", refTime * 1000 / numFrames);
+	printf("New: %.3f ms/frame\n", newTime * 1000 / numFrames);
+
+	// ړ_Ƃ̉ZႤ̂Ō덷e
+	const float tolerance = 1e-3f;
+	float maxDiff = 0;
+	for (int i = 0; i < numFrames; ++i) {
+		for (int f = 0; f <= 10; ++f) {
+			maxDiff = std::max(maxDiff, std::abs(expected[i].p[f] - actual[i].p[f]));
+			maxDiff = std::max(maxDiff, std::abs(expected[i].t[f] - actual[i].t[f]));
+			maxDiff = std::max(maxDiff, std::abs(expected[i].b[f] - actual[i].b[f]));
+		}
+	}
+	printf("ő덷: %g\n", maxDiff);
+	if (maxDiff > tolerance) {
+		THROWF(TestException, "͌ʂ̌덷傫܂(%g)", maxDiff);
+	}
+
+	return 0;
+}
+
+// ScratchArenãACgEԋpEq[vmۉ񐔂̃eXg
+// t[Ƃ̊mۂ͂āA2ڈȍ~̓q[vmۂȂƂmF
+static int ScratchArenaTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	auto isAligned = [](const void* p) {
+		return ((uintptr_t)p % ScratchArena::ALIGN) == 0;
+	};
+	auto frame = [&](size_t frameSize) {
+		ScratchArena::Scope scratch;
+		float* memCopy = scratch.alloc<float>(frameSize);
+		float* memDeint = scratch.alloc<float>(frameSize);
+		if (!isAligned(memCopy) || !isAligned(memDeint)) {
+			THROW(TestException, "ACgĂ܂");
+		}
+		std::fill_n(memCopy, frameSize, 1.0f);
+		std::fill_n(memDeint, frameSize, 2.0f);
+		{
+			// qScope͊Ö̗󂳂Ȃ
+			ScratchArena::Scope inner;
+			int* work = inner.alloc<int>(frameSize * 3);
+			if (!isAligned(work)) {
+				THROW(TestException, "ACgĂ܂");
+			}
+			std::fill_n(work, frameSize * 3, -1);
+		}
+		uint8_t* small = scratch.alloc<uint8_t>(3);
+		if (!isAligned(small)) {
+			THROW(TestException, "ACgĂ܂");
+		}
+		if (memCopy[frameSize - 1] != 1.0f || memDeint[frameSize - 1] != 2.0f) {
+			THROW(TestException, "mۂ̈悪󂳂Ă܂");
+		}
+	};
+
+	// [J[XbhŊmFĩXbh̃A[ȉԂɈˑȂ悤Ɂj
+	int numHeapAllocs = 0;
+	size_t capacity = 0;
+	ParallelWorkers workers(1);
+	workers.post(1, [&](int threadIndex, int i) {
+		ScratchArena& arena = ScratchArena::current();
+		const size_t frameSize = 1920 * 1080;
+		frame(frameSize);
+		int warmup = arena.getNumHeapAllocs();
+		for (int n = 0; n < 100; ++n) {
+			frame(frameSize);
+			// mۂ̈Ɏ܂
+			frame(1000);
+		}
+		if (arena.getNumHeapAllocs() != warmup) {
+			THROWF(TestException, "ԂŃq[vmۂĂ܂(%d -> %d)",
+				warmup, arena.getNumHeapAllocs());
+		}
+		numHeapAllocs = arena.getNumHeapAllocs();
+		capacity = arena.getCapacity();
+	});
+	workers.wait();
+	ctx.infoF("q[vmۉ: %d, mۍς: %.1fMB", numHeapAllocs, capacity / (1024.0 * 1024.0));
+
+	return 0;
+}
+
+// Sp̓t@C̏݁Eǂݍ݂mF
+static int LogoAnalysisFileTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const tstring& path = setting.getSrcFilePath();
+	const int numFrames = 1000;
+
+	std::vector<logo::LogoFadeFrame> frames(numFrames);
+	for (int n = 0; n < numFrames; ++n) {
+		logo::LogoAnalyzeFrame info;
+		for (int f = 0; f <= 10; ++f) {
+			info.p[f] = (float)std::abs(f - n % 11);
+			info.t[f] = (float)std::abs(f - (n / 11) % 11);
+			info.b[f] = (float)std::abs(f - (n * 7) % 11);
+		}
+		frames[n] = logo::MinFades(info);
+		if (frames[n].p != n % 11 || frames[n].t != (n / 11) % 11 || frames[n].b != (n * 7) % 11) {
+			THROWF(TestException, "t[%d̍ŏtF[hv܂", n);
+		}
+	}
+
+	logo::LogoFadeFile::save(path, frames);
+
+	std::vector<logo::LogoFadeFrame> loaded;
+	if (!logo::LogoFadeFile::load(path, numFrames, loaded)) {
+		THROW(TestException, "̓t@C̓ǂݍ݂Ɏs܂");
+	}
+	for (int n = 0; n < numFrames; ++n) {
+		if (loaded[n].p != frames[n].p || loaded[n].t != frames[n].t || loaded[n].b != frames[n].b) {
+			THROWF(TestException, "t[%d̉͌ʂv܂", n);
+		}
+	}
+
+	// t[Ⴄ\[Xɂ͎gȂ
+	if (logo::LogoFadeFile::load(path, numFrames + 1, loaded)) {
+		THROW(TestException, "t[̈Ⴄ̓t@Cǂݍ߂Ă܂܂");
+	}
+
+	// ͈͊O̒l͕sȃt@C
+	frames[numFrames / 2].t = 11;
+	logo::LogoFadeFile::save(path, frames);
+	if (logo::LogoFadeFile::load(path, numFrames, loaded)) {
+		THROW(TestException, "sȉ̓t@Cǂݍ߂Ă܂܂");
+	}
+
+	removeT(path.c_str());
+	ctx.info("OK");
+
+	return 0;
+}
+
+// S쐬pt[̕ۑێƃt@Cۑ̗ŊmF
+static int LogoScanFrameStoreTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const tstring& workfile = setting.getSrcFilePath();
+	const int w = 200, h = 80;
+	const int numFrames = 1000;
+	const size_t frameSize = w * h * 3 / 2;
+
+	srand(0);
+	std::vector<uint8_t> src(frameSize * numFrames);
+	for (auto& v : src) {
+		// k悤ɒl͈̔͂
+		v = (uint8_t)(rand() % 16 + 100);
+	}
+
+	ParallelWorkers workers(GetProcessorCount());
+	const size_t limits[] = { frameSize * numFrames, frameSize * numFrames / 3 };
+	for (size_t limit : limits) {
+		Stopwatch sw;
+		sw.start();
+		logo::LogoScanFrameStore store(ctx, workfile, w, h, numFrames, limit);
+		for (int i = 0; i < numFrames; ++i) {
+			store.addFrame(&src[i * frameSize]);
+		}
+		store.finish();
+		double addTime = sw.getAndReset();
+
+		std::vector<int> numVisits(numFrames);
+		std::atomic<int> numErrors(0);
+		for (int start = 0; start < numFrames; start += 256) {
+			int end = std::min(numFrames, start + 256);
+			store.forEachFrame(&workers, start, end, [&](int threadIndex, int i, const uint8_t* frame) {
+				numVisits[i]++;
+				if (memcmp(frame, &src[i * frameSize], frameSize) != 0) {
+					numErrors++;
+				}
+			});
+		}
+		int next = 0;
+		store.forEachFrame(nullptr, 0, numFrames, [&](int threadIndex, int i, const uint8_t* frame) {
+			if (i != next++ || memcmp(frame, &src[i * frameSize], frameSize) != 0) {
+				numErrors++;
+			}
+		});
+		double readTime = sw.getAndReset();
+
+		if (numErrors > 0 || std::count(numVisits.begin(), numVisits.end(), 1) != numFrames) {
+			THROWF(TestException, "t[v܂(%s)", store.isOnMemory() ? "" : "t@C");
+		}
+		if (store.isOnMemory() != (limit >= frameSize * numFrames)) {
+			THROW(TestException, "ێĂ܂");
+		}
+		ctx.infoF("%s: ǉ %.1fms ǂݍ %.1fms", store.isOnMemory() ? "" : "t@C",
+			addTime * 1000, readTime * 1000);
+	}
+
+	removeT(workfile.c_str());
+
+	return 0;
+}
+
+// 1̃tB^sƃLbVǂݍ݂ŕ̃GR[_ɓ͂ł邩
+static int FilterEncodeMultiTest(AMTContext& ctx, const ConfigWrapper& setting)
+{
+	const tstring& base = setting.getSrcFilePath();
+	const int numFrames = 60;
+	auto env = make_unique_ptr(CreateScriptEnvironment2());
+
+	PClip clip = env->Invoke("Eval", AVSValue(StringFormat(
+		"BlankClip(length=%d, width=320, height=240, fps=30, pixel_type=\"YV12\", color_yuv=$4080C0)",
+		numFrames).c_str())).AsClip();
+
+	VideoFormat fmt = VideoFormat();
+	fmt.format = VS_H264;
+	fmt.width = fmt.displayWidth = 320;
+	fmt.height = fmt.displayHeight = 240;
+	fmt.sarWidth = fmt.sarHeight = 1;
+	fmt.frameRateNum = 30;
+	fmt.frameRateDenom = 1;
+	fmt.colorPrimaries = AVCOL_PRI_UNSPECIFIED;
+	fmt.transferCharacteristics = AVCOL_TRC_UNSPECIFIED;
+	fmt.colorSpace = AVCOL_SPC_UNSPECIFIED;
+	fmt.progressive = true;
+	fmt.fixedFrameRate = true;
+
+	const int numEncoders = 2;
+	std::vector<tstring> outpaths;
+	for (int i = 0; i < numEncoders; ++i) {
+		outpaths.push_back(StringFormat(_T("%s.%d.264"), base, i));
+	}
+	tstring cachePath = base + _T(".dat");
+
+	// 2pXƂo͐ 2pXڂ̓LbV̓͂ɂȂ
+	std::vector<std::vector<tstring>> passArgs(2);
+	for (auto& args : passArgs) {
+		for (const tstring& outpath : outpaths) {
+			args.push_back(makeEncoderArgs(ENCODER_X264, setting.getEncoderPath(),
+				_T("--preset ultrafast --crf 30"), fmt, tstring(), 0, outpath));
+		}
+	}
+
+	AMTFilterVideoEncoder encoder(ctx, 8);
+	encoder.encode(clip, fmt, std::vector<double>(), passArgs, env.get(), cachePath);
+
+	if (!File::exists(cachePath)) {
+		THROW(TestException, "tB^o͂ۑĂ܂");
+	}
+	for (const tstring& outpath : outpaths) {
+		if (!File::exists(outpath) || File(outpath, _T("rb")).size() == 0) {
+			THROWF(TestException, "GR[_̏o͂܂: %s", outpath);
+		}
+	}
+
+	for (const tstring& outpath : outpaths) {
+		removeT(outpath.c_str());
+	}
+	removeT(cachePath.c_str());
+	ctx.info("OK");
+
+	return 0;
+}
+
 } // namespace test
@@ -4,6 +4,87 @@
 
 #include "ProcessThread.hpp"
 #include "StreamReform.hpp"
+#include "AdtsParser.hpp"
+
+// FilterAudioFramePCMf[^i16bitXeIjǂ
+// wavepath̏ꍇ͒wavet@CȂ̂ŁAԉt@CKvȃt[fR[h
+class WaveFrameReader : public AMTObject {
+public:
+	WaveFrameReader(AMTContext& ctx, const tstring& wavepath, const tstring& aacpath)
+		: AMTObject(ctx)
+		, decoder(ctx)
+		, decodedOffset(-1)
+	{
+		if (wavepath.size() > 0) {
+			waveFile = std::unique_ptr<File>(new File(wavepath, _T("rb")));
+		}
+		else {
+			aacFile = std::unique_ptr<File>(new File(aacpath, _T("rb")));
+		}
+	}
+
+	// framePCMf[^offsetoCgڂdst.lengthoCgǂ
+	void read(const FilterAudioFrame& frame, int offset, MemoryChunk dst) {
+		if (frame.waveLength == 0) {
+			// waveȂꍇ̓[߂
+			memset(dst.data, 0x00, dst.length);
+		}
+		else if (waveFile != nullptr) {
+			waveFile->seek(frame.waveOffset + offset, SEEK_SET);
+			waveFile->read(dst);
+		}
+		else {
+			decodeFrame(frame);
+			memcpy(dst.data, decoded.data() + offset, dst.length);
+		}
+	}
+
+private:
+	std::unique_ptr<File> waveFile;
+	std::unique_ptr<File> aacFile;
+	AdtsDecoder decoder;
+	std::vector<uint8_t> coded;
+	std::vector<uint8_t> decoded;
+	int64_t decodedOffset; // decoded̃t[codedOffset
+
+	void decodeFrame(const FilterAudioFrame& frame) {
+		if (frame.codedOffset == decodedOffset) {
+			// OɃfR[ht[
+			return;
+		}
+		NeAACDecFrameInfo frameInfo;
+		void* samples;
+		bool channelError;
+		if (frame.prevCodedOffset != decodedOffset) {
+			// Õt[瑱ĂȂiJbgV[Nj
+			// AAC͑Õt[̏ԂĝŃfR[_ĒÕt[Ŋ炵Ă
+			decoder.reset();
+			if (frame.prevCodedOffset >= 0) {
+				readCoded(frame.prevCodedOffset, frame.prevCodedLength);
+				decoder.decode(coded.data(), (int)coded.size(), frameInfo, samples, channelError);
+			}
+		}
+
+		readCoded(frame.codedOffset, frame.codedLength);
+		decodedOffset = frame.codedOffset;
+
+		if (decoder.decode(coded.data(), (int)coded.size(), frameInfo, samples, channelError) &&
+			(int)frameInfo.samples * 2 == frame.waveLength)
+		{
+			decoded.assign((uint8_t*)samples, (uint8_t*)samples + frame.waveLength);
+		}
+		else {
+			// fR[hłȂ疳ɂ
+			decoded.assign(frame.waveLength, 0);
+		}
+	}
+
+	void readCoded(int64_t offset, int length) {
+		coded.resize(length);
+		aacFile->seek(offset, SEEK_SET);
+		aacFile->read(MemoryChunk(coded.data(), coded.size()));
+	}
+};
 
 namespace wave {
 
@@ -33,8 +114,9 @@ void set4(int8_t dst[4], const char* src) {
 
 } // namespace wave {
 
+// wavepath̏ꍇaacpathfR[h
 void EncodeAudio(AMTContext& ctx, const tstring& encoder_args,
-	const tstring& audiopath, const AudioFormat& afmt,
+	const tstring& wavepath, const tstring& aacpath, const AudioFormat& afmt,
 	const std::vector<FilterAudioFrame>& audioFrames)
 {
 	using namespace wave;
@@ -73,22 +155,14 @@ void EncodeAudio(AMTContext& ctx, const tstring& encoder_args,
 		}
 	}
 
-	File srcFile(audiopath, _T("rb"));
+	WaveFrameReader reader(ctx, wavepath, aacpath);
 	AutoBuffer buffer;
 	int frameWaveLength = audioSamplesPerFrame * bytesPerSample * nchannels;
 	MemoryChunk mc = buffer.space(frameWaveLength);
 	mc.length = frameWaveLength;
 
 	for (size_t i = 0; i < audioFrames.size(); ++i) {
-		if (audioFrames[i].waveLength != 0) {
-			// waveȂǂ
-			srcFile.seek(audioFrames[i].waveOffset, SEEK_SET);
-			srcFile.read(mc);
-		}
-		else {
-			// Ȃꍇ̓[߂
-			memset(mc.data, 0x00, mc.length);
-		}
+		reader.read(audioFrames[i], 0, mc);
 		process->write(mc);
 	}
 
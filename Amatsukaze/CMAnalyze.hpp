@@ -31,12 +31,41 @@ public:
 		Stopwatch sw;
 		tstring avspath = makeAVSFile(videoFileIndex);
 
-		// S
-		if (setting_.getLogoPath().size() > 0 || setting_.getEraseLogoPath().size() > 0) {
-			ctx.info("[S]");
-			sw.start();
-			logoFrame(videoFileIndex, avspath);
-			ctx.infoF(": %.2fb", sw.getAndReset());
+		// S͂ƃ`v^[͂͂ǂԃt@CSfR[h邾
+		// ݂ɈˑȂ̂ŕɎs
+		bool doLogo = (setting_.getLogoPath().size() > 0 || setting_.getEraseLogoPath().size() > 0);
+		double logoTime = 0, chapterTime = 0;
+		if (doLogo) {
+			ctx.info("[S + EV[`FW]");
+		}
+		else {
+			ctx.info("[EV[`FW]");
+		}
+		sw.start();
+		if (doLogo) {
+			// ꎞt@C̓o^iAMTContext::registerTmpFilej̓XbhZ[tȂ̂
+			// eXbhŃpX擾Ă悢
+			ParallelWorkers workers(2);
+			workers.run(2, [&](int threadIndex, int itemIndex) {
+				Stopwatch phasesw;
+				phasesw.start();
+				if (itemIndex == 0) {
+					chapterExe(videoFileIndex, avspath);
+					chapterTime = phasesw.getAndReset();
+				}
+				else {
+					logoFrame(videoFileIndex, avspath);
+					logoTime = phasesw.getAndReset();
+				}
+			});
+		}
+		else {
+			chapterExe(videoFileIndex, avspath);
+		}
+		double totalTime = sw.getAndReset();
+		if (doLogo) {
+			ctx.infoF(": %.2fb (S: %.2fb, EV[`FW: %.2fb)",
+				totalTime, logoTime, chapterTime);
 
 			ctx.info("[S͌]");
 			if (logopath.size() > 0) {
@@ -49,12 +78,9 @@ public:
 				PrintFileAll(setting_.getTmpLogoFramePath(videoFileIndex, i));
 			}
 		}
-
-		// `v^[
-		ctx.info("[EV[`FW]");
-		sw.start();
-		chapterExe(videoFileIndex, avspath);
-		ctx.infoF(": %.2fb", sw.getAndReset());
+		else {
+			ctx.infoF(": %.2fb", totalTime);
+		}
 
 		ctx.info("[EV[`FW͌]");
 		PrintFileAll(setting_.getTmpChapterExeOutPath(videoFileIndex));
@@ -288,7 +314,11 @@ private:
 
 			std::vector<tstring> allLogoPath = logoPath;
 			allLogoPath.insert(allLogoPath.end(), eraseLogoPath.begin(), eraseLogoPath.end());
-			logo::LogoFrame logof(ctx, allLogoPath, 0.35f);
+			logo::LogoFrame logof(ctx, allLogoPath, 0.35f, setting_.getNumLogoScanThreads());
+			if (setting_.isReuseLogoAnalysis()) {
+				// AMTEraseLogo(AMTAnalyzeLogo)Ɠ}XN
+				logof.enableFadeAnalysis(0.35f);
+			}
 			logof.scanFrames(clip, env.get());
 
 			if (logoPath.size() > 0) {
@@ -304,11 +334,17 @@ private:
 				}
 				else {
 					logopath = setting_.getLogoPath()[logof.getBestLogo()];
+					if (setting_.isReuseLogoAnalysis()) {
+						logof.writeFadeAnalysis(setting_.getTmpLogoAnalysisPath(videoFileIndex));
+					}
 				}
 			}
 
 			for (int i = 0; i < (int)eraseLogoPath.size(); ++i) {
 				logof.writeResult(setting_.getTmpLogoFramePath(videoFileIndex, i), (int)logoPath.size() + i);
+				if (setting_.isReuseLogoAnalysis()) {
+					logof.writeFadeAnalysis(setting_.getTmpLogoAnalysisPath(videoFileIndex, i), (int)logoPath.size() + i);
+				}
 			}
 		}
 		catch (const AvisynthError& avserror) {
@@ -12,7 +12,7 @@
 #include <stdio.h>
 
 struct CPUInfo {
-	bool initialized, avx, avx2;
+	bool initialized, avx, avx2, avx512;
 };
 
 static CPUInfo g_cpuinfo;
@@ -24,6 +24,7 @@ static inline void InitCPUInfo() {
 		g_cpuinfo.avx = cpuinfo[2] & (1 << 28) || false;
 		bool osxsaveSupported = cpuinfo[2] & (1 << 27) || false;
 		g_cpuinfo.avx2 = false;
+		g_cpuinfo.avx512 = false;
 		if (osxsaveSupported && g_cpuinfo.avx)
 		{
 			// _XCR_XFEATURE_ENABLED_MASK = 0
@@ -32,6 +33,8 @@ static inline void InitCPUInfo() {
 			if (g_cpuinfo.avx) {
 				__cpuid(cpuinfo, 7);
 				g_cpuinfo.avx2 = cpuinfo[1] & (1 << 5) || false;
+				// AVX512F  OSZMMWX^ۑ
+				g_cpuinfo.avx512 = (cpuinfo[1] & (1 << 16)) && (xcrFeatureMask & 0xE0) == 0xE0;
 			}
 		}
 		g_cpuinfo.initialized = true;
@@ -48,6 +51,11 @@ bool IsAVX2Available() {
 	return g_cpuinfo.avx2;
 }
 
+bool IsAVX512Available() {
+	InitCPUInfo();
+	return g_cpuinfo.avx512;
+}
+
 // https://qiita.com/beru/items/fff00c19968685dada68
 // in  : ( x7, x6, x5, x4, x3, x2, x1, x0 )
 // out : ( -,  -,  -, xsum )
@@ -0,0 +1,218 @@
+/**
+* Amtasukaze Logo Compute Kernel
+* Copyright (c) 2017-2019 Nekopanda
+*
+* This software is released under the MIT License.
+* http://opensource.org/licenses/mit-license.php
+*/
+#pragma once
+
+#include <stdint.h>
+
+// ComputeKernel.cpp
+bool IsAVXAvailable();
+bool IsAVX2Available();
+bool IsAVX512Available();
+
+// S͗pJ[lZbg
+// C̓t@XĩXJ[ƓZj
+// SIMDł͑փXRA̍vȊOCƓZȂ̂ŁA
+// LogoScoreȊǑʂCƈv
+struct LogoKernelSet {
+	const char* name;
+
+	// ㉺̃CƍăC^i擪ƍŌ̃C̓Rs[j
+	void(*DeintY8)(float* dst, const uint8_t* src, int srcPitch, int w, int h);
+	void(*DeintY16)(float* dst, const uint16_t* src, int srcPitch, int w, int h);
+
+	// dst = fade * (A * src + B * maxv) + (1 - fade) * src
+	void(*RemoveLogo)(float* dst, const float* src, int srcStride,
+		const float* A, const float* B, int w, int h, float maxv, float fade);
+
+	// ړ_Ƃ5x5ւ𐳋Kčv
+	// offsets: ړ_̈ʒuix + y * wj
+	// kernels: ^bvƂɒړ_ׂJ[l kernels[tap * kstride + _]
+	// scales: ړ_ƂɕϋPx̒iK(256>>3)(scale,scale2)
+	float(*LogoScore)(const float* Y, int w, const int* offsets,
+		const float* kernels, int kstride, const float* scales, int numPoints);
+
+	// fades[f]ƂRemoveLogoLogoScorelresult[f]ɏށinumFades <= LOGO_KERNEL_MAX_FADESj
+	// wi̓tF[hɑ΂Đ`Ȃ̂ŁAړ_ƂɌ摜ƍiwi-摜j̃^bv1񂾂Wv
+	// StF[h̕ςƑւ߂BZႤ̂RemoveLogo+LogoScoreƂ͌덷͈̔͂ňv
+	// src: 摜ioffsetsw𕝂ƂʒuȂ̂srcStrideœǂݑւj
+	void(*LogoScoreFades)(float* result, const float* fades, int numFades,
+		const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+		const int* offsets, const float* kernels, int kstride, const float* scales, int numPoints);
+
+	// AMTEraseLogõSidstj
+	// dst = clamp(fade * (A * dst + B * maxv) + (1 - fade) * dst + 0.5, 0, maxv) ؂̂
+	void(*Delogo8)(uint8_t* dst, int w, int h, int logoPitch, int dstPitch,
+		float maxv, const float* A, const float* B, float fade);
+	void(*Delogo16)(uint16_t* dst, int w, int h, int logoPitch, int dstPitch,
+		float maxv, const float* A, const float* B, float fade);
+
+	// 5x5EBhE̕ςl2aiO2sNZ͏܂Ȃj
+	void(*Variance5x5)(float* dst, const float* Y, int w, int h);
+
+	// 3x3őltB^iLogoScan::maxfilterƓj
+	void(*MaxFilter3)(float* data, float* work, int w, int h);
+};
+
+enum {
+	LOGO_KERNEL_KSIZE = 5,
+	LOGO_KERNEL_KLEN = LOGO_KERNEL_KSIZE * LOGO_KERNEL_KSIZE,
+	LOGO_KERNEL_CSHIFT = 3,
+	LOGO_KERNEL_CLEN = 256 >> LOGO_KERNEL_CSHIFT,
+	// kernels̒ړ_͂̔{ɑ邱
+	LOGO_KERNEL_ALIGN = 16,
+	// LogoScoreFadesňxɕ]łtF[hl̐
+	LOGO_KERNEL_MAX_FADES = 16,
+};
+
+// ComputeKernelSSE2.cpp
+const LogoKernelSet& GetLogoKernelC();
+const LogoKernelSet& GetLogoKernelSSE2();
+// CPUɍ킹čő̂̂Ԃ
+const LogoKernelSet& GetLogoKernel();
+
+// ComputeKernelAVX2.cpp
+const LogoKernelSet& GetLogoKernelAVX2();
+
+// ComputeKernelAVX512.cpp
+const LogoKernelSet& GetLogoKernelAVX512();
+
+// ȉ͊e̒[̏p
+// ߃Zbg̈Ⴄ|PʂŎĝŁAKstaticɂ邱ƁiinlineƃNɂǂꂩ1ɓĂ܂j
+namespace logo_kernel {
+
+template <typename pixel_t>
+static float DeintPixel(const pixel_t* src, int srcPitch) {
+	return (src[-srcPitch] + 2 * src[0] + src[srcPitch] + 2) / 4.0f;
+}
+
+template <typename pixel_t>
+static void DeintEdgeLines(float* dst, const pixel_t* src, int srcPitch, int w, int h) {
+	for (int x = 0; x < w; ++x) {
+		dst[x] = src[x];
+		dst[x + (h - 1) * w] = src[x + (h - 1) * srcPitch];
+	}
+}
+
+static float RemoveLogoPixel(float srcv, float a, float b, float maxv, float fade) {
+	float bg = a * srcv + b * maxv;
+	return fade * bg + (1 - fade) * srcv;
+}
+
+template <typename pixel_t>
+static pixel_t DelogoPixel(pixel_t src, float a, float b, float maxv, float fade) {
+	float tmp = RemoveLogoPixel(src, a, b, maxv, fade) + 0.5f;
+	// std::min(std::max(tmp, 0.0f), maxv)Ɠ
+	tmp = (tmp < 0.0f) ? 0.0f : tmp;
+	tmp = (maxv < tmp) ? maxv : tmp;
+	return (pixel_t)tmp;
+}
+
+template <typename pixel_t>
+static void DelogoLine(pixel_t* dst, const float* A, const float* B, int x, int w, float maxv, float fade) {
+	for (; x < w; ++x) {
+		dst[x] = DelogoPixel(dst[x], A[x], B[x], maxv, fade);
+	}
+}
+
+// ړ_ȋ֒l𐳋K
+static float NormalizeScore(float sum, float avg, const float* scales, int i) {
+	// avgPF̏ꍇ̑֒l1ɂȂ悤ɐK
+	int c = (avg < 0.0f) ? 0 : (avg < 255.0f) ? (int)avg : 255;
+	const float* s = &scales[(i * LOGO_KERNEL_CLEN + (c >> LOGO_KERNEL_CSHIFT)) * 2];
+	// 1𒴂镔͎̂ĂiSɂ鑊ւł͂ȂȂ̂Łj
+	float scaled = sum * s[0];
+	float normalized = (scaled < 1.0f) ? scaled : 1.0f;
+	normalized = (-1.0f < normalized) ? normalized : -1.0f;
+	// ւlȉ̏ꍇ͈ꕔɖ߂
+	return normalized * s[1];
+}
+
+static float LogoScorePoint(const float* Y, int w, const int* offsets,
+	const float* kernels, int kstride, const float* scales, int i)
+{
+	const float* p = Y + offsets[i];
+	float avg = 0.0f;
+	for (int ky = -2; ky <= 2; ++ky) {
+		for (int kx = -2; kx <= 2; ++kx) {
+			avg += p[kx + ky * w];
+		}
+	}
+	avg /= LOGO_KERNEL_KLEN;
+	float sum = 0.0f;
+	for (int ky = -2; ky <= 2; ++ky) {
+		for (int kx = -2; kx <= 2; ++kx) {
+			sum += kernels[((kx + 2) + (ky + 2) * LOGO_KERNEL_KSIZE) * kstride + i] * (p[kx + ky * w] - avg);
+		}
+	}
+	return NormalizeScore(sum, avg, scales, i);
+}
+
+// offsetsiwj̈ʒusrcStrideł̈ʒuɕϊ
+static int SrcOffset(int off, int w, int srcStride) {
+	int y = off / w;
+	return (off - y * w) + y * srcStride;
+}
+
+// ړ_i̊etF[h̃XRAresultɉZ
+static void LogoScoreFadesPoint(float* result, const float* fades, int numFades,
+	const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+	const int* offsets, const float* kernels, int kstride, const float* scales, int i)
+{
+	const float* s = src + SrcOffset(offsets[i], w, srcStride);
+	const float* a = A + offsets[i];
+	const float* b = B + offsets[i];
+	float tapS[LOGO_KERNEL_KLEN], tapD[LOGO_KERNEL_KLEN];
+	float avgS = 0.0f, avgD = 0.0f;
+	for (int ky = -2, t = 0; ky <= 2; ++ky) {
+		for (int kx = -2; kx <= 2; ++kx, ++t) {
+			float srcv = s[kx + ky * srcStride];
+			float bg = a[kx + ky * w] * srcv + b[kx + ky * w] * maxv;
+			tapS[t] = srcv;
+			tapD[t] = bg - srcv;
+			avgS += tapS[t];
+			avgD += tapD[t];
+		}
+	}
+	avgS /= LOGO_KERNEL_KLEN;
+	avgD /= LOGO_KERNEL_KLEN;
+	float sumS = 0.0f, sumD = 0.0f;
+	for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+		float k = kernels[t * kstride + i];
+		sumS += k * (tapS[t] - avgS);
+		sumD += k * (tapD[t] - avgD);
+	}
+	for (int f = 0; f < numFades; ++f) {
+		result[f] += NormalizeScore(sumS + fades[f] * sumD, avgS + fades[f] * avgD, scales, i);
+	}
+}
+
+static float Variance5x5Pixel(const float* Y, int w) {
+	float avg = 0.0f;
+	for (int ky = -2; ky <= 2; ++ky) {
+		for (int kx = -2; kx <= 2; ++kx) {
+			avg += Y[kx + ky * w];
+		}
+	}
+	avg /= LOGO_KERNEL_KLEN;
+	float sum = 0.0f;
+	for (int ky = -2; ky <= 2; ++ky) {
+		for (int kx = -2; kx <= 2; ++kx) {
+			float d = Y[kx + ky * w] - avg;
+			sum += d * d;
+		}
+	}
+	return sum;
+}
+
+static float Max3(float a, float b, float c) {
+	// std::max(a, std::max(b, c))Ɠ
+	float bc = (b < c) ? c : b;
+	return (a < bc) ? bc : a;
+}
+
+} // namespace logo_kernel
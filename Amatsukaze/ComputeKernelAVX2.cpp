@@ -0,0 +1,329 @@
+/**
+* Amtasukaze Logo Compute Kernel (AVX2)
+* Copyright (c) 2017-2019 Nekopanda
+*
+* This software is released under the MIT License.
+* http://opensource.org/licenses/mit-license.php
+*/
+
+// ̃t@CAVX2ŃRpC
+#include <immintrin.h>
+#include "ComputeKernel.h"
+
+// [̏iXJ[jFMAɕϊCƌʂς̂ŋ֎~
+#pragma fp_contract(off)
+
+using namespace logo_kernel;
+
+static inline __m256i LoadPixel8(const uint8_t* src) {
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+}
+
+static inline __m256i LoadPixel8(const uint16_t* src) {
+	return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)src));
+}
+
+template <typename pixel_t>
+static void DeintY_AVX2(float* dst, const pixel_t* src, int srcPitch, int w, int h)
+{
+	const __m256i two = _mm256_set1_epi32(2);
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	DeintEdgeLines(dst, src, srcPitch, w, h);
+	for (int y = 1; y < h - 1; ++y) {
+		const pixel_t* s = src + y * srcPitch;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 8 <= w; x += 8) {
+			__m256i a = LoadPixel8(s + x - srcPitch);
+			__m256i b = LoadPixel8(s + x);
+			__m256i c = LoadPixel8(s + x + srcPitch);
+			__m256i sum = _mm256_add_epi32(_mm256_add_epi32(a, _mm256_slli_epi32(b, 1)), _mm256_add_epi32(c, two));
+			// 4ł̏Z0.25{Ɠi덷Ȃj
+			_mm256_storeu_ps(d + x, _mm256_mul_ps(_mm256_cvtepi32_ps(sum), quarter));
+		}
+		for (; x < w; ++x) {
+			d[x] = DeintPixel(s + x, srcPitch);
+		}
+	}
+}
+
+static void RemoveLogo_AVX2(float* dst, const float* src, int srcStride,
+	const float* A, const float* B, int w, int h, float maxv, float fade)
+{
+	const __m256 vmaxv = _mm256_set1_ps(maxv);
+	const __m256 vfade = _mm256_set1_ps(fade);
+	const __m256 vfade1 = _mm256_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		const float* s = src + y * srcStride;
+		const float* a = A + y * w;
+		const float* b = B + y * w;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 8 <= w; x += 8) {
+			// FMAɂCƌʂς̂ŎgȂ
+			__m256 srcv = _mm256_loadu_ps(s + x);
+			__m256 bg = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a + x), srcv), _mm256_mul_ps(_mm256_loadu_ps(b + x), vmaxv));
+			_mm256_storeu_ps(d + x, _mm256_add_ps(_mm256_mul_ps(vfade, bg), _mm256_mul_ps(vfade1, srcv)));
+		}
+		for (; x < w; ++x) {
+			d[x] = RemoveLogoPixel(s[x], a[x], b[x], maxv, fade);
+		}
+	}
+}
+
+static float LogoScore_AVX2(const float* Y, int w, const int* offsets,
+	const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m256 vzero = _mm256_setzero_ps();
+	const __m256 v255 = _mm256_set1_ps(255.0f);
+	const __m256 vone = _mm256_set1_ps(1.0f);
+	const __m256 vminus1 = _mm256_set1_ps(-1.0f);
+	const __m256 vklen = _mm256_set1_ps((float)LOGO_KERNEL_KLEN);
+	const __m256i vlane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256 vresult = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= numPoints; i += 8) {
+		const __m256i voff = _mm256_loadu_si256((const __m256i*)(offsets + i));
+		__m256 taps[LOGO_KERNEL_KLEN];
+		__m256 avg = _mm256_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				__m256i idx = _mm256_add_epi32(voff, _mm256_set1_epi32(kx + ky * w));
+				taps[t] = _mm256_i32gather_ps(Y, idx, 4);
+				avg = _mm256_add_ps(avg, taps[t]);
+			}
+		}
+		avg = _mm256_div_ps(avg, vklen);
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m256 k = _mm256_loadu_ps(kernels + t * kstride + i);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(k, _mm256_sub_ps(taps[t], avg)));
+		}
+		// 0`255ɃNvĂ؂̂ĂĂʂ͓
+		__m256i c = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(avg, vzero), v255));
+		// (i * CLEN + (c >> CSHIFT)) * 2
+		__m256i idx = _mm256_slli_epi32(_mm256_add_epi32(
+			_mm256_slli_epi32(_mm256_add_epi32(_mm256_set1_epi32(i), vlane), 8 - LOGO_KERNEL_CSHIFT),
+			_mm256_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+		__m256 scale = _mm256_i32gather_ps(scales, idx, 4);
+		__m256 scale2 = _mm256_i32gather_ps(scales + 1, idx, 4);
+		__m256 normalized = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(sum, scale), vone), vminus1);
+		vresult = _mm256_add_ps(vresult, _mm256_mul_ps(normalized, scale2));
+	}
+	__m128 r4 = _mm_add_ps(_mm256_castps256_ps128(vresult), _mm256_extractf128_ps(vresult, 1));
+	__m128 r2 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+	float result = _mm_cvtss_f32(_mm_add_ss(r2, _mm_shuffle_ps(r2, r2, 1)));
+	for (; i < numPoints; ++i) {
+		result += LogoScorePoint(Y, w, offsets, kernels, kstride, scales, i);
+	}
+	return result;
+}
+
+static void LogoScoreFades_AVX2(float* result, const float* fades, int numFades,
+	const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+	const int* offsets, const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m256 vzero = _mm256_setzero_ps();
+	const __m256 v255 = _mm256_set1_ps(255.0f);
+	const __m256 vone = _mm256_set1_ps(1.0f);
+	const __m256 vminus1 = _mm256_set1_ps(-1.0f);
+	const __m256 vklen = _mm256_set1_ps((float)LOGO_KERNEL_KLEN);
+	const __m256 vmaxv = _mm256_set1_ps(maxv);
+	const __m256i vlane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256 vresult[LOGO_KERNEL_MAX_FADES];
+	for (int f = 0; f < numFades; ++f) {
+		vresult[f] = _mm256_setzero_ps();
+	}
+	int i = 0;
+	for (; i + 8 <= numPoints; i += 8) {
+		const __m256i voff = _mm256_loadu_si256((const __m256i*)(offsets + i));
+		alignas(32) int soff[8];
+		for (int l = 0; l < 8; ++l) {
+			soff[l] = SrcOffset(offsets[i + l], w, srcStride);
+		}
+		const __m256i vsoff = _mm256_load_si256((const __m256i*)soff);
+		__m256 tapS[LOGO_KERNEL_KLEN], tapD[LOGO_KERNEL_KLEN];
+		__m256 avgS = _mm256_setzero_ps();
+		__m256 avgD = _mm256_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				__m256i idx = _mm256_add_epi32(voff, _mm256_set1_epi32(kx + ky * w));
+				__m256i sidx = _mm256_add_epi32(vsoff, _mm256_set1_epi32(kx + ky * srcStride));
+				__m256 srcv = _mm256_i32gather_ps(src, sidx, 4);
+				// FMAɂCƌʂς̂ŎgȂ
+				__m256 bg = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(A, idx, 4), srcv),
+					_mm256_mul_ps(_mm256_i32gather_ps(B, idx, 4), vmaxv));
+				tapS[t] = srcv;
+				tapD[t] = _mm256_sub_ps(bg, srcv);
+				avgS = _mm256_add_ps(avgS, tapS[t]);
+				avgD = _mm256_add_ps(avgD, tapD[t]);
+			}
+		}
+		avgS = _mm256_div_ps(avgS, vklen);
+		avgD = _mm256_div_ps(avgD, vklen);
+		__m256 sumS = _mm256_setzero_ps();
+		__m256 sumD = _mm256_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m256 k = _mm256_loadu_ps(kernels + t * kstride + i);
+			sumS = _mm256_add_ps(sumS, _mm256_mul_ps(k, _mm256_sub_ps(tapS[t], avgS)));
+			sumD = _mm256_add_ps(sumD, _mm256_mul_ps(k, _mm256_sub_ps(tapD[t], avgD)));
+		}
+		const __m256i vbase = _mm256_slli_epi32(_mm256_add_epi32(_mm256_set1_epi32(i), vlane), 8 - LOGO_KERNEL_CSHIFT);
+		for (int f = 0; f < numFades; ++f) {
+			__m256 vfade = _mm256_set1_ps(fades[f]);
+			__m256 avg = _mm256_add_ps(avgS, _mm256_mul_ps(vfade, avgD));
+			__m256 sum = _mm256_add_ps(sumS, _mm256_mul_ps(vfade, sumD));
+			__m256i c = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(avg, vzero), v255));
+			__m256i idx = _mm256_slli_epi32(_mm256_add_epi32(vbase, _mm256_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+			__m256 scale = _mm256_i32gather_ps(scales, idx, 4);
+			__m256 scale2 = _mm256_i32gather_ps(scales + 1, idx, 4);
+			__m256 normalized = _mm256_max_ps(_mm256_min_ps(_mm256_mul_ps(sum, scale), vone), vminus1);
+			vresult[f] = _mm256_add_ps(vresult[f], _mm256_mul_ps(normalized, scale2));
+		}
+	}
+	for (int f = 0; f < numFades; ++f) {
+		__m128 r4 = _mm_add_ps(_mm256_castps256_ps128(vresult[f]), _mm256_extractf128_ps(vresult[f], 1));
+		__m128 r2 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+		result[f] = _mm_cvtss_f32(_mm_add_ss(r2, _mm_shuffle_ps(r2, r2, 1)));
+	}
+	for (; i < numPoints; ++i) {
+		LogoScoreFadesPoint(result, fades, numFades, src, srcStride, A, B, maxv, w, offsets, kernels, kstride, scales, i);
+	}
+}
+
+// wǐvZNv܂RemoveLogoPixel, DelogoPixelƓZ
+static inline __m256i DelogoPixel8_AVX2(__m256i src, const float* a, const float* b,
+	__m256 vmaxv, __m256 vfade, __m256 vfade1)
+{
+	const __m256 vhalf = _mm256_set1_ps(0.5f);
+	// FMAɂCƌʂς̂ŎgȂ
+	__m256 srcv = _mm256_cvtepi32_ps(src);
+	__m256 bg = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(a), srcv), _mm256_mul_ps(_mm256_loadu_ps(b), vmaxv));
+	__m256 tmp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vfade, bg), _mm256_mul_ps(vfade1, srcv)), vhalf);
+	tmp = _mm256_min_ps(_mm256_max_ps(tmp, _mm256_setzero_ps()), vmaxv);
+	return _mm256_cvttps_epi32(tmp);
+}
+
+static void Delogo8_AVX2(uint8_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m256 vmaxv = _mm256_set1_ps(maxv);
+	const __m256 vfade = _mm256_set1_ps(fade);
+	const __m256 vfade1 = _mm256_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint8_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m256i r0 = DelogoPixel8_AVX2(LoadPixel8(d + x), a + x, b + x, vmaxv, vfade, vfade1);
+			__m256i r1 = DelogoPixel8_AVX2(LoadPixel8(d + x + 8), a + x + 8, b + x + 8, vmaxv, vfade, vfade1);
+			// pack̓[ƂȂ̂ŕג
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(r0, r1), 0xD8);
+			_mm_storeu_si128((__m128i*)(d + x),
+				_mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)));
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Delogo16_AVX2(uint16_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m256 vmaxv = _mm256_set1_ps(maxv);
+	const __m256 vfade = _mm256_set1_ps(fade);
+	const __m256 vfade1 = _mm256_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint16_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m256i r0 = DelogoPixel8_AVX2(LoadPixel8(d + x), a + x, b + x, vmaxv, vfade, vfade1);
+			__m256i r1 = DelogoPixel8_AVX2(LoadPixel8(d + x + 8), a + x + 8, b + x + 8, vmaxv, vfade, vfade1);
+			// pack̓[ƂȂ̂ŕג
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(r0, r1), 0xD8);
+			_mm256_storeu_si256((__m256i*)(d + x), packed);
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Variance5x5_AVX2(float* dst, const float* Y, int w, int h)
+{
+	const __m256 vklen = _mm256_set1_ps((float)LOGO_KERNEL_KLEN);
+	for (int y = 2; y < h - 2; ++y) {
+		int x = 2;
+		for (; x + 8 <= w - 2; x += 8) {
+			const float* p = Y + x + y * w;
+			__m256 avg = _mm256_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					avg = _mm256_add_ps(avg, _mm256_loadu_ps(p + kx + ky * w));
+				}
+			}
+			avg = _mm256_div_ps(avg, vklen);
+			__m256 sum = _mm256_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					__m256 d = _mm256_sub_ps(_mm256_loadu_ps(p + kx + ky * w), avg);
+					sum = _mm256_add_ps(sum, _mm256_mul_ps(d, d));
+				}
+			}
+			_mm256_storeu_ps(dst + x + y * w, sum);
+		}
+		for (; x < w - 2; ++x) {
+			dst[x + y * w] = Variance5x5Pixel(Y + x + y * w, w);
+		}
+	}
+}
+
+// std::max(a, std::max(b, c))Ɠ
+static inline __m256 Max3_AVX2(__m256 a, __m256 b, __m256 c) {
+	return _mm256_max_ps(_mm256_max_ps(c, b), a);
+}
+
+static void MaxFilter3_AVX2(float* data, float* work, int w, int h)
+{
+	for (int y = 0; y < h; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		d[0] = s[0];
+		int x = 1;
+		for (; x + 8 <= w - 1; x += 8) {
+			_mm256_storeu_ps(d + x, Max3_AVX2(_mm256_loadu_ps(s + x - 1), _mm256_loadu_ps(s + x), _mm256_loadu_ps(s + x + 1)));
+		}
+		for (; x < w - 1; ++x) {
+			d[x] = Max3(s[x - 1], s[x], s[x + 1]);
+		}
+		d[w - 1] = s[w - 1];
+	}
+	for (int y = 1; y < h - 1; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		int x = 0;
+		for (; x + 8 <= w; x += 8) {
+			_mm256_storeu_ps(d + x, Max3_AVX2(_mm256_loadu_ps(s + x - w), _mm256_loadu_ps(s + x), _mm256_loadu_ps(s + x + w)));
+		}
+		for (; x < w; ++x) {
+			d[x] = Max3(s[x - w], s[x], s[x + w]);
+		}
+	}
+}
+
+const LogoKernelSet& GetLogoKernelAVX2()
+{
+	static const LogoKernelSet kernel = {
+		"AVX2",
+		DeintY_AVX2<uint8_t>,
+		DeintY_AVX2<uint16_t>,
+		RemoveLogo_AVX2,
+		LogoScore_AVX2,
+		LogoScoreFades_AVX2,
+		Delogo8_AVX2,
+		Delogo16_AVX2,
+		Variance5x5_AVX2,
+		MaxFilter3_AVX2
+	};
+	return kernel;
+}
@@ -0,0 +1,318 @@
+/**
+* Amtasukaze Logo Compute Kernel (AVX-512)
+* Copyright (c) 2017-2019 Nekopanda
+*
+* This software is released under the MIT License.
+* http://opensource.org/licenses/mit-license.php
+*/
+
+// ̃t@CAVX-512ŃRpC
+#include <immintrin.h>
+#include "ComputeKernel.h"
+
+// [̏iXJ[jFMAɕϊCƌʂς̂ŋ֎~
+#pragma fp_contract(off)
+
+using namespace logo_kernel;
+
+static inline __m512i LoadPixel16(const uint8_t* src) {
+	return _mm512_cvtepu8_epi32(_mm_loadu_si128((const __m128i*)src));
+}
+
+static inline __m512i LoadPixel16(const uint16_t* src) {
+	return _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)src));
+}
+
+template <typename pixel_t>
+static void DeintY_AVX512(float* dst, const pixel_t* src, int srcPitch, int w, int h)
+{
+	const __m512i two = _mm512_set1_epi32(2);
+	const __m512 quarter = _mm512_set1_ps(0.25f);
+	DeintEdgeLines(dst, src, srcPitch, w, h);
+	for (int y = 1; y < h - 1; ++y) {
+		const pixel_t* s = src + y * srcPitch;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m512i a = LoadPixel16(s + x - srcPitch);
+			__m512i b = LoadPixel16(s + x);
+			__m512i c = LoadPixel16(s + x + srcPitch);
+			__m512i sum = _mm512_add_epi32(_mm512_add_epi32(a, _mm512_slli_epi32(b, 1)), _mm512_add_epi32(c, two));
+			// 4ł̏Z0.25{Ɠi덷Ȃj
+			_mm512_storeu_ps(d + x, _mm512_mul_ps(_mm512_cvtepi32_ps(sum), quarter));
+		}
+		for (; x < w; ++x) {
+			d[x] = DeintPixel(s + x, srcPitch);
+		}
+	}
+}
+
+static void RemoveLogo_AVX512(float* dst, const float* src, int srcStride,
+	const float* A, const float* B, int w, int h, float maxv, float fade)
+{
+	const __m512 vmaxv = _mm512_set1_ps(maxv);
+	const __m512 vfade = _mm512_set1_ps(fade);
+	const __m512 vfade1 = _mm512_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		const float* s = src + y * srcStride;
+		const float* a = A + y * w;
+		const float* b = B + y * w;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			// FMAɂCƌʂς̂ŎgȂ
+			__m512 srcv = _mm512_loadu_ps(s + x);
+			__m512 bg = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(a + x), srcv), _mm512_mul_ps(_mm512_loadu_ps(b + x), vmaxv));
+			_mm512_storeu_ps(d + x, _mm512_add_ps(_mm512_mul_ps(vfade, bg), _mm512_mul_ps(vfade1, srcv)));
+		}
+		for (; x < w; ++x) {
+			d[x] = RemoveLogoPixel(s[x], a[x], b[x], maxv, fade);
+		}
+	}
+}
+
+static float LogoScore_AVX512(const float* Y, int w, const int* offsets,
+	const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m512 vzero = _mm512_setzero_ps();
+	const __m512 v255 = _mm512_set1_ps(255.0f);
+	const __m512 vone = _mm512_set1_ps(1.0f);
+	const __m512 vminus1 = _mm512_set1_ps(-1.0f);
+	const __m512 vklen = _mm512_set1_ps((float)LOGO_KERNEL_KLEN);
+	const __m512i vlane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	__m512 vresult = _mm512_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= numPoints; i += 16) {
+		const __m512i voff = _mm512_loadu_si512(offsets + i);
+		__m512 taps[LOGO_KERNEL_KLEN];
+		__m512 avg = _mm512_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				__m512i idx = _mm512_add_epi32(voff, _mm512_set1_epi32(kx + ky * w));
+				taps[t] = _mm512_i32gather_ps(idx, Y, 4);
+				avg = _mm512_add_ps(avg, taps[t]);
+			}
+		}
+		avg = _mm512_div_ps(avg, vklen);
+		__m512 sum = _mm512_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m512 k = _mm512_loadu_ps(kernels + t * kstride + i);
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(k, _mm512_sub_ps(taps[t], avg)));
+		}
+		// 0`255ɃNvĂ؂̂ĂĂʂ͓
+		__m512i c = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(avg, vzero), v255));
+		// (i * CLEN + (c >> CSHIFT)) * 2
+		__m512i idx = _mm512_slli_epi32(_mm512_add_epi32(
+			_mm512_slli_epi32(_mm512_add_epi32(_mm512_set1_epi32(i), vlane), 8 - LOGO_KERNEL_CSHIFT),
+			_mm512_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+		__m512 scale = _mm512_i32gather_ps(idx, scales, 4);
+		__m512 scale2 = _mm512_i32gather_ps(idx, scales + 1, 4);
+		__m512 normalized = _mm512_max_ps(_mm512_min_ps(_mm512_mul_ps(sum, scale), vone), vminus1);
+		vresult = _mm512_add_ps(vresult, _mm512_mul_ps(normalized, scale2));
+	}
+	float result = _mm512_reduce_add_ps(vresult);
+	for (; i < numPoints; ++i) {
+		result += LogoScorePoint(Y, w, offsets, kernels, kstride, scales, i);
+	}
+	return result;
+}
+
+static void LogoScoreFades_AVX512(float* result, const float* fades, int numFades,
+	const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+	const int* offsets, const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m512 vzero = _mm512_setzero_ps();
+	const __m512 v255 = _mm512_set1_ps(255.0f);
+	const __m512 vone = _mm512_set1_ps(1.0f);
+	const __m512 vminus1 = _mm512_set1_ps(-1.0f);
+	const __m512 vklen = _mm512_set1_ps((float)LOGO_KERNEL_KLEN);
+	const __m512 vmaxv = _mm512_set1_ps(maxv);
+	const __m512i vlane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	__m512 vresult[LOGO_KERNEL_MAX_FADES];
+	for (int f = 0; f < numFades; ++f) {
+		vresult[f] = _mm512_setzero_ps();
+	}
+	int i = 0;
+	for (; i + 16 <= numPoints; i += 16) {
+		const __m512i voff = _mm512_loadu_si512(offsets + i);
+		alignas(64) int soff[16];
+		for (int l = 0; l < 16; ++l) {
+			soff[l] = SrcOffset(offsets[i + l], w, srcStride);
+		}
+		const __m512i vsoff = _mm512_load_si512(soff);
+		__m512 tapS[LOGO_KERNEL_KLEN], tapD[LOGO_KERNEL_KLEN];
+		__m512 avgS = _mm512_setzero_ps();
+		__m512 avgD = _mm512_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				__m512i idx = _mm512_add_epi32(voff, _mm512_set1_epi32(kx + ky * w));
+				__m512i sidx = _mm512_add_epi32(vsoff, _mm512_set1_epi32(kx + ky * srcStride));
+				__m512 srcv = _mm512_i32gather_ps(sidx, src, 4);
+				// FMAɂCƌʂς̂ŎgȂ
+				__m512 bg = _mm512_add_ps(_mm512_mul_ps(_mm512_i32gather_ps(idx, A, 4), srcv),
+					_mm512_mul_ps(_mm512_i32gather_ps(idx, B, 4), vmaxv));
+				tapS[t] = srcv;
+				tapD[t] = _mm512_sub_ps(bg, srcv);
+				avgS = _mm512_add_ps(avgS, tapS[t]);
+				avgD = _mm512_add_ps(avgD, tapD[t]);
+			}
+		}
+		avgS = _mm512_div_ps(avgS, vklen);
+		avgD = _mm512_div_ps(avgD, vklen);
+		__m512 sumS = _mm512_setzero_ps();
+		__m512 sumD = _mm512_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m512 k = _mm512_loadu_ps(kernels + t * kstride + i);
+			sumS = _mm512_add_ps(sumS, _mm512_mul_ps(k, _mm512_sub_ps(tapS[t], avgS)));
+			sumD = _mm512_add_ps(sumD, _mm512_mul_ps(k, _mm512_sub_ps(tapD[t], avgD)));
+		}
+		const __m512i vbase = _mm512_slli_epi32(_mm512_add_epi32(_mm512_set1_epi32(i), vlane), 8 - LOGO_KERNEL_CSHIFT);
+		for (int f = 0; f < numFades; ++f) {
+			__m512 vfade = _mm512_set1_ps(fades[f]);
+			__m512 avg = _mm512_add_ps(avgS, _mm512_mul_ps(vfade, avgD));
+			__m512 sum = _mm512_add_ps(sumS, _mm512_mul_ps(vfade, sumD));
+			__m512i c = _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(avg, vzero), v255));
+			__m512i idx = _mm512_slli_epi32(_mm512_add_epi32(vbase, _mm512_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+			__m512 scale = _mm512_i32gather_ps(idx, scales, 4);
+			__m512 scale2 = _mm512_i32gather_ps(idx, scales + 1, 4);
+			__m512 normalized = _mm512_max_ps(_mm512_min_ps(_mm512_mul_ps(sum, scale), vone), vminus1);
+			vresult[f] = _mm512_add_ps(vresult[f], _mm512_mul_ps(normalized, scale2));
+		}
+	}
+	for (int f = 0; f < numFades; ++f) {
+		result[f] = _mm512_reduce_add_ps(vresult[f]);
+	}
+	for (; i < numPoints; ++i) {
+		LogoScoreFadesPoint(result, fades, numFades, src, srcStride, A, B, maxv, w, offsets, kernels, kstride, scales, i);
+	}
+}
+
+// wǐvZNv܂RemoveLogoPixel, DelogoPixelƓZ
+static inline __m512i DelogoPixel16_AVX512(__m512i src, const float* a, const float* b,
+	__m512 vmaxv, __m512 vfade, __m512 vfade1)
+{
+	const __m512 vhalf = _mm512_set1_ps(0.5f);
+	// FMAɂCƌʂς̂ŎgȂ
+	__m512 srcv = _mm512_cvtepi32_ps(src);
+	__m512 bg = _mm512_add_ps(_mm512_mul_ps(_mm512_loadu_ps(a), srcv), _mm512_mul_ps(_mm512_loadu_ps(b), vmaxv));
+	__m512 tmp = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(vfade, bg), _mm512_mul_ps(vfade1, srcv)), vhalf);
+	tmp = _mm512_min_ps(_mm512_max_ps(tmp, _mm512_setzero_ps()), vmaxv);
+	return _mm512_cvttps_epi32(tmp);
+}
+
+static void Delogo8_AVX512(uint8_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m512 vmaxv = _mm512_set1_ps(maxv);
+	const __m512 vfade = _mm512_set1_ps(fade);
+	const __m512 vfade1 = _mm512_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint8_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m512i r = DelogoPixel16_AVX512(LoadPixel16(d + x), a + x, b + x, vmaxv, vfade, vfade1);
+			_mm_storeu_si128((__m128i*)(d + x), _mm512_cvtusepi32_epi8(r));
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Delogo16_AVX512(uint16_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m512 vmaxv = _mm512_set1_ps(maxv);
+	const __m512 vfade = _mm512_set1_ps(fade);
+	const __m512 vfade1 = _mm512_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint16_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m512i r = DelogoPixel16_AVX512(LoadPixel16(d + x), a + x, b + x, vmaxv, vfade, vfade1);
+			_mm256_storeu_si256((__m256i*)(d + x), _mm512_cvtusepi32_epi16(r));
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Variance5x5_AVX512(float* dst, const float* Y, int w, int h)
+{
+	const __m512 vklen = _mm512_set1_ps((float)LOGO_KERNEL_KLEN);
+	for (int y = 2; y < h - 2; ++y) {
+		int x = 2;
+		for (; x + 16 <= w - 2; x += 16) {
+			const float* p = Y + x + y * w;
+			__m512 avg = _mm512_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					avg = _mm512_add_ps(avg, _mm512_loadu_ps(p + kx + ky * w));
+				}
+			}
+			avg = _mm512_div_ps(avg, vklen);
+			__m512 sum = _mm512_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					__m512 d = _mm512_sub_ps(_mm512_loadu_ps(p + kx + ky * w), avg);
+					sum = _mm512_add_ps(sum, _mm512_mul_ps(d, d));
+				}
+			}
+			_mm512_storeu_ps(dst + x + y * w, sum);
+		}
+		for (; x < w - 2; ++x) {
+			dst[x + y * w] = Variance5x5Pixel(Y + x + y * w, w);
+		}
+	}
+}
+
+// std::max(a, std::max(b, c))Ɠ
+static inline __m512 Max3_AVX512(__m512 a, __m512 b, __m512 c) {
+	return _mm512_max_ps(_mm512_max_ps(c, b), a);
+}
+
+static void MaxFilter3_AVX512(float* data, float* work, int w, int h)
+{
+	for (int y = 0; y < h; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		d[0] = s[0];
+		int x = 1;
+		for (; x + 16 <= w - 1; x += 16) {
+			_mm512_storeu_ps(d + x, Max3_AVX512(_mm512_loadu_ps(s + x - 1), _mm512_loadu_ps(s + x), _mm512_loadu_ps(s + x + 1)));
+		}
+		for (; x < w - 1; ++x) {
+			d[x] = Max3(s[x - 1], s[x], s[x + 1]);
+		}
+		d[w - 1] = s[w - 1];
+	}
+	for (int y = 1; y < h - 1; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			_mm512_storeu_ps(d + x, Max3_AVX512(_mm512_loadu_ps(s + x - w), _mm512_loadu_ps(s + x), _mm512_loadu_ps(s + x + w)));
+		}
+		for (; x < w; ++x) {
+			d[x] = Max3(s[x - w], s[x], s[x + w]);
+		}
+	}
+}
+
+const LogoKernelSet& GetLogoKernelAVX512()
+{
+	static const LogoKernelSet kernel = {
+		"AVX-512",
+		DeintY_AVX512<uint8_t>,
+		DeintY_AVX512<uint16_t>,
+		RemoveLogo_AVX512,
+		LogoScore_AVX512,
+		LogoScoreFades_AVX512,
+		Delogo8_AVX512,
+		Delogo16_AVX512,
+		Variance5x5_AVX512,
+		MaxFilter3_AVX512
+	};
+	return kernel;
+}
@@ -0,0 +1,449 @@
+/**
+* Amtasukaze Logo Compute Kernel (C/SSE2)
+* Copyright (c) 2017-2019 Nekopanda
+*
+* This software is released under the MIT License.
+* http://opensource.org/licenses/mit-license.php
+*/
+
+// ̃t@C͊g߂Ȃix64ȂSSE2jŃRpC
+#include <emmintrin.h>
+#include "ComputeKernel.h"
+
+using namespace logo_kernel;
+
+// Cit@Xj //
+
+template <typename pixel_t>
+static void DeintY_C(float* dst, const pixel_t* src, int srcPitch, int w, int h)
+{
+	DeintEdgeLines(dst, src, srcPitch, w, h);
+	for (int y = 1; y < h - 1; ++y) {
+		for (int x = 0; x < w; ++x) {
+			dst[x + y * w] = DeintPixel(src + x + y * srcPitch, srcPitch);
+		}
+	}
+}
+
+static void RemoveLogo_C(float* dst, const float* src, int srcStride,
+	const float* A, const float* B, int w, int h, float maxv, float fade)
+{
+	for (int y = 0; y < h; ++y) {
+		for (int x = 0; x < w; ++x) {
+			dst[x + y * w] = RemoveLogoPixel(src[x + y * srcStride], A[x + y * w], B[x + y * w], maxv, fade);
+		}
+	}
+}
+
+static float LogoScore_C(const float* Y, int w, const int* offsets,
+	const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	float result = 0;
+	for (int i = 0; i < numPoints; ++i) {
+		result += LogoScorePoint(Y, w, offsets, kernels, kstride, scales, i);
+	}
+	return result;
+}
+
+static void LogoScoreFades_C(float* result, const float* fades, int numFades,
+	const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+	const int* offsets, const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	for (int f = 0; f < numFades; ++f) {
+		result[f] = 0.0f;
+	}
+	for (int i = 0; i < numPoints; ++i) {
+		LogoScoreFadesPoint(result, fades, numFades, src, srcStride, A, B, maxv, w, offsets, kernels, kstride, scales, i);
+	}
+}
+
+template <typename pixel_t>
+static void Delogo_C(pixel_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	for (int y = 0; y < h; ++y) {
+		DelogoLine(dst + y * dstPitch, A + y * logoPitch, B + y * logoPitch, 0, w, maxv, fade);
+	}
+}
+
+static void Variance5x5_C(float* dst, const float* Y, int w, int h)
+{
+	for (int y = 2; y < h - 2; ++y) {
+		for (int x = 2; x < w - 2; ++x) {
+			dst[x + y * w] = Variance5x5Pixel(Y + x + y * w, w);
+		}
+	}
+}
+
+static void MaxFilter3_C(float* data, float* work, int w, int h)
+{
+	for (int y = 0; y < h; ++y) {
+		work[0 + y * w] = data[0 + y * w];
+		for (int x = 1; x < w - 1; ++x) {
+			work[x + y * w] = Max3(data[x - 1 + y * w], data[x + y * w], data[x + 1 + y * w]);
+		}
+		work[w - 1 + y * w] = data[w - 1 + y * w];
+	}
+	for (int y = 1; y < h - 1; ++y) {
+		for (int x = 0; x < w; ++x) {
+			work[x + y * w] = Max3(data[x + (y - 1) * w], data[x + y * w], data[x + (y + 1) * w]);
+		}
+	}
+}
+
+// SSE2 //
+
+static inline __m128i LoadPixel4(const uint8_t* src) {
+	__m128i v = _mm_cvtsi32_si128(*(const int*)src);
+	v = _mm_unpacklo_epi8(v, _mm_setzero_si128());
+	return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+}
+
+static inline __m128i LoadPixel4(const uint16_t* src) {
+	__m128i v = _mm_loadl_epi64((const __m128i*)src);
+	return _mm_unpacklo_epi16(v, _mm_setzero_si128());
+}
+
+template <typename pixel_t>
+static void DeintY_SSE2(float* dst, const pixel_t* src, int srcPitch, int w, int h)
+{
+	const __m128i two = _mm_set1_epi32(2);
+	const __m128 quarter = _mm_set1_ps(0.25f);
+	DeintEdgeLines(dst, src, srcPitch, w, h);
+	for (int y = 1; y < h - 1; ++y) {
+		const pixel_t* s = src + y * srcPitch;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 4 <= w; x += 4) {
+			__m128i a = LoadPixel4(s + x - srcPitch);
+			__m128i b = LoadPixel4(s + x);
+			__m128i c = LoadPixel4(s + x + srcPitch);
+			__m128i sum = _mm_add_epi32(_mm_add_epi32(a, _mm_slli_epi32(b, 1)), _mm_add_epi32(c, two));
+			// 4ł̏Z0.25{Ɠi덷Ȃj
+			_mm_storeu_ps(d + x, _mm_mul_ps(_mm_cvtepi32_ps(sum), quarter));
+		}
+		for (; x < w; ++x) {
+			d[x] = DeintPixel(s + x, srcPitch);
+		}
+	}
+}
+
+static void RemoveLogo_SSE2(float* dst, const float* src, int srcStride,
+	const float* A, const float* B, int w, int h, float maxv, float fade)
+{
+	const __m128 vmaxv = _mm_set1_ps(maxv);
+	const __m128 vfade = _mm_set1_ps(fade);
+	const __m128 vfade1 = _mm_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		const float* s = src + y * srcStride;
+		const float* a = A + y * w;
+		const float* b = B + y * w;
+		float* d = dst + y * w;
+		int x = 0;
+		for (; x + 4 <= w; x += 4) {
+			__m128 srcv = _mm_loadu_ps(s + x);
+			__m128 bg = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a + x), srcv), _mm_mul_ps(_mm_loadu_ps(b + x), vmaxv));
+			_mm_storeu_ps(d + x, _mm_add_ps(_mm_mul_ps(vfade, bg), _mm_mul_ps(vfade1, srcv)));
+		}
+		for (; x < w; ++x) {
+			d[x] = RemoveLogoPixel(s[x], a[x], b[x], maxv, fade);
+		}
+	}
+}
+
+static inline __m128 Gather4(const float* base, const int* idx) {
+	return _mm_set_ps(base[idx[3]], base[idx[2]], base[idx[1]], base[idx[0]]);
+}
+
+static float LogoScore_SSE2(const float* Y, int w, const int* offsets,
+	const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m128 vzero = _mm_setzero_ps();
+	const __m128 v255 = _mm_set1_ps(255.0f);
+	const __m128 vone = _mm_set1_ps(1.0f);
+	const __m128 vminus1 = _mm_set1_ps(-1.0f);
+	const __m128 vklen = _mm_set1_ps((float)LOGO_KERNEL_KLEN);
+	__m128 vresult = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 4 <= numPoints; i += 4) {
+		__m128 taps[LOGO_KERNEL_KLEN];
+		__m128 avg = _mm_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				int off = kx + ky * w;
+				taps[t] = _mm_set_ps(Y[offsets[i + 3] + off], Y[offsets[i + 2] + off],
+					Y[offsets[i + 1] + off], Y[offsets[i] + off]);
+				avg = _mm_add_ps(avg, taps[t]);
+			}
+		}
+		avg = _mm_div_ps(avg, vklen);
+		__m128 sum = _mm_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m128 k = _mm_loadu_ps(kernels + t * kstride + i);
+			sum = _mm_add_ps(sum, _mm_mul_ps(k, _mm_sub_ps(taps[t], avg)));
+		}
+		// 0`255ɃNvĂ؂̂ĂĂʂ͓
+		__m128i c = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(avg, vzero), v255));
+		// (i * CLEN + (c >> CSHIFT)) * 2
+		__m128i idx = _mm_slli_epi32(_mm_add_epi32(
+			_mm_slli_epi32(_mm_set_epi32(i + 3, i + 2, i + 1, i), 8 - LOGO_KERNEL_CSHIFT),
+			_mm_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+		alignas(16) int sidx[4];
+		_mm_store_si128((__m128i*)sidx, idx);
+		__m128 scale = Gather4(scales, sidx);
+		__m128 scale2 = Gather4(scales + 1, sidx);
+		__m128 normalized = _mm_max_ps(_mm_min_ps(_mm_mul_ps(sum, scale), vone), vminus1);
+		vresult = _mm_add_ps(vresult, _mm_mul_ps(normalized, scale2));
+	}
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, vresult);
+	float result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for (; i < numPoints; ++i) {
+		result += LogoScorePoint(Y, w, offsets, kernels, kstride, scales, i);
+	}
+	return result;
+}
+
+static void LogoScoreFades_SSE2(float* result, const float* fades, int numFades,
+	const float* src, int srcStride, const float* A, const float* B, float maxv, int w,
+	const int* offsets, const float* kernels, int kstride, const float* scales, int numPoints)
+{
+	const __m128 vzero = _mm_setzero_ps();
+	const __m128 v255 = _mm_set1_ps(255.0f);
+	const __m128 vone = _mm_set1_ps(1.0f);
+	const __m128 vminus1 = _mm_set1_ps(-1.0f);
+	const __m128 vklen = _mm_set1_ps((float)LOGO_KERNEL_KLEN);
+	const __m128 vmaxv = _mm_set1_ps(maxv);
+	__m128 vresult[LOGO_KERNEL_MAX_FADES];
+	for (int f = 0; f < numFades; ++f) {
+		vresult[f] = _mm_setzero_ps();
+	}
+	int i = 0;
+	for (; i + 4 <= numPoints; i += 4) {
+		int soff[4];
+		for (int l = 0; l < 4; ++l) {
+			soff[l] = SrcOffset(offsets[i + l], w, srcStride);
+		}
+		__m128 tapS[LOGO_KERNEL_KLEN], tapD[LOGO_KERNEL_KLEN];
+		__m128 avgS = _mm_setzero_ps();
+		__m128 avgD = _mm_setzero_ps();
+		for (int ky = -2, t = 0; ky <= 2; ++ky) {
+			for (int kx = -2; kx <= 2; ++kx, ++t) {
+				int off = kx + ky * w;
+				int soffk = kx + ky * srcStride;
+				__m128 srcv = _mm_set_ps(src[soff[3] + soffk], src[soff[2] + soffk],
+					src[soff[1] + soffk], src[soff[0] + soffk]);
+				__m128 a = _mm_set_ps(A[offsets[i + 3] + off], A[offsets[i + 2] + off],
+					A[offsets[i + 1] + off], A[offsets[i] + off]);
+				__m128 b = _mm_set_ps(B[offsets[i + 3] + off], B[offsets[i + 2] + off],
+					B[offsets[i + 1] + off], B[offsets[i] + off]);
+				__m128 bg = _mm_add_ps(_mm_mul_ps(a, srcv), _mm_mul_ps(b, vmaxv));
+				tapS[t] = srcv;
+				tapD[t] = _mm_sub_ps(bg, srcv);
+				avgS = _mm_add_ps(avgS, tapS[t]);
+				avgD = _mm_add_ps(avgD, tapD[t]);
+			}
+		}
+		avgS = _mm_div_ps(avgS, vklen);
+		avgD = _mm_div_ps(avgD, vklen);
+		__m128 sumS = _mm_setzero_ps();
+		__m128 sumD = _mm_setzero_ps();
+		for (int t = 0; t < LOGO_KERNEL_KLEN; ++t) {
+			__m128 k = _mm_loadu_ps(kernels + t * kstride + i);
+			sumS = _mm_add_ps(sumS, _mm_mul_ps(k, _mm_sub_ps(tapS[t], avgS)));
+			sumD = _mm_add_ps(sumD, _mm_mul_ps(k, _mm_sub_ps(tapD[t], avgD)));
+		}
+		const __m128i vbase = _mm_slli_epi32(_mm_set_epi32(i + 3, i + 2, i + 1, i), 8 - LOGO_KERNEL_CSHIFT);
+		for (int f = 0; f < numFades; ++f) {
+			__m128 vfade = _mm_set1_ps(fades[f]);
+			__m128 avg = _mm_add_ps(avgS, _mm_mul_ps(vfade, avgD));
+			__m128 sum = _mm_add_ps(sumS, _mm_mul_ps(vfade, sumD));
+			__m128i c = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(avg, vzero), v255));
+			__m128i idx = _mm_slli_epi32(_mm_add_epi32(vbase, _mm_srli_epi32(c, LOGO_KERNEL_CSHIFT)), 1);
+			alignas(16) int sidx[4];
+			_mm_store_si128((__m128i*)sidx, idx);
+			__m128 scale = Gather4(scales, sidx);
+			__m128 scale2 = Gather4(scales + 1, sidx);
+			__m128 normalized = _mm_max_ps(_mm_min_ps(_mm_mul_ps(sum, scale), vone), vminus1);
+			vresult[f] = _mm_add_ps(vresult[f], _mm_mul_ps(normalized, scale2));
+		}
+	}
+	for (int f = 0; f < numFades; ++f) {
+		alignas(16) float lanes[4];
+		_mm_store_ps(lanes, vresult[f]);
+		result[f] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	}
+	for (; i < numPoints; ++i) {
+		LogoScoreFadesPoint(result, fades, numFades, src, srcStride, A, B, maxv, w, offsets, kernels, kstride, scales, i);
+	}
+}
+
+// wǐvZNv܂RemoveLogoPixel, DelogoPixelƓZ
+static inline __m128i DelogoPixel4_SSE2(__m128i src, const float* a, const float* b,
+	__m128 vmaxv, __m128 vfade, __m128 vfade1)
+{
+	const __m128 vhalf = _mm_set1_ps(0.5f);
+	__m128 srcv = _mm_cvtepi32_ps(src);
+	__m128 bg = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(a), srcv), _mm_mul_ps(_mm_loadu_ps(b), vmaxv));
+	__m128 tmp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vfade, bg), _mm_mul_ps(vfade1, srcv)), vhalf);
+	tmp = _mm_min_ps(_mm_max_ps(tmp, _mm_setzero_ps()), vmaxv);
+	return _mm_cvttps_epi32(tmp);
+}
+
+static void Delogo8_SSE2(uint8_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 vmaxv = _mm_set1_ps(maxv);
+	const __m128 vfade = _mm_set1_ps(fade);
+	const __m128 vfade1 = _mm_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint8_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 16 <= w; x += 16) {
+			__m128i src = _mm_loadu_si128((const __m128i*)(d + x));
+			__m128i lo = _mm_unpacklo_epi8(src, zero);
+			__m128i hi = _mm_unpackhi_epi8(src, zero);
+			__m128i r0 = DelogoPixel4_SSE2(_mm_unpacklo_epi16(lo, zero), a + x, b + x, vmaxv, vfade, vfade1);
+			__m128i r1 = DelogoPixel4_SSE2(_mm_unpackhi_epi16(lo, zero), a + x + 4, b + x + 4, vmaxv, vfade, vfade1);
+			__m128i r2 = DelogoPixel4_SSE2(_mm_unpacklo_epi16(hi, zero), a + x + 8, b + x + 8, vmaxv, vfade, vfade1);
+			__m128i r3 = DelogoPixel4_SSE2(_mm_unpackhi_epi16(hi, zero), a + x + 12, b + x + 12, vmaxv, vfade, vfade1);
+			// 0`255ɃNvς݂Ȃ̂ŖOaȂ
+			_mm_storeu_si128((__m128i*)(d + x), _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3)));
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Delogo16_SSE2(uint16_t* dst, int w, int h, int logoPitch, int dstPitch,
+	float maxv, const float* A, const float* B, float fade)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+	const __m128 vmaxv = _mm_set1_ps(maxv);
+	const __m128 vfade = _mm_set1_ps(fade);
+	const __m128 vfade1 = _mm_set1_ps(1 - fade);
+	for (int y = 0; y < h; ++y) {
+		uint16_t* d = dst + y * dstPitch;
+		const float* a = A + y * logoPitch;
+		const float* b = B + y * logoPitch;
+		int x = 0;
+		for (; x + 8 <= w; x += 8) {
+			__m128i src = _mm_loadu_si128((const __m128i*)(d + x));
+			__m128i r0 = DelogoPixel4_SSE2(_mm_unpacklo_epi16(src, zero), a + x, b + x, vmaxv, vfade, vfade1);
+			__m128i r1 = DelogoPixel4_SSE2(_mm_unpackhi_epi16(src, zero), a + x + 4, b + x + 4, vmaxv, vfade, vfade1);
+			// SSE2ɂ͕ȂpackȂ̂ł炵ĕtpack
+			__m128i packed = _mm_packs_epi32(_mm_sub_epi32(r0, bias32), _mm_sub_epi32(r1, bias32));
+			_mm_storeu_si128((__m128i*)(d + x), _mm_add_epi16(packed, bias16));
+		}
+		DelogoLine(d, a, b, x, w, maxv, fade);
+	}
+}
+
+static void Variance5x5_SSE2(float* dst, const float* Y, int w, int h)
+{
+	const __m128 vklen = _mm_set1_ps((float)LOGO_KERNEL_KLEN);
+	for (int y = 2; y < h - 2; ++y) {
+		int x = 2;
+		for (; x + 4 <= w - 2; x += 4) {
+			const float* p = Y + x + y * w;
+			__m128 avg = _mm_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					avg = _mm_add_ps(avg, _mm_loadu_ps(p + kx + ky * w));
+				}
+			}
+			avg = _mm_div_ps(avg, vklen);
+			__m128 sum = _mm_setzero_ps();
+			for (int ky = -2; ky <= 2; ++ky) {
+				for (int kx = -2; kx <= 2; ++kx) {
+					__m128 d = _mm_sub_ps(_mm_loadu_ps(p + kx + ky * w), avg);
+					sum = _mm_add_ps(sum, _mm_mul_ps(d, d));
+				}
+			}
+			_mm_storeu_ps(dst + x + y * w, sum);
+		}
+		for (; x < w - 2; ++x) {
+			dst[x + y * w] = Variance5x5Pixel(Y + x + y * w, w);
+		}
+	}
+}
+
+// std::max(a, std::max(b, c))Ɠ
+static inline __m128 Max3_SSE2(__m128 a, __m128 b, __m128 c) {
+	return _mm_max_ps(_mm_max_ps(c, b), a);
+}
+
+static void MaxFilter3_SSE2(float* data, float* work, int w, int h)
+{
+	for (int y = 0; y < h; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		d[0] = s[0];
+		int x = 1;
+		for (; x + 4 <= w - 1; x += 4) {
+			_mm_storeu_ps(d + x, Max3_SSE2(_mm_loadu_ps(s + x - 1), _mm_loadu_ps(s + x), _mm_loadu_ps(s + x + 1)));
+		}
+		for (; x < w - 1; ++x) {
+			d[x] = Max3(s[x - 1], s[x], s[x + 1]);
+		}
+		d[w - 1] = s[w - 1];
+	}
+	for (int y = 1; y < h - 1; ++y) {
+		const float* s = data + y * w;
+		float* d = work + y * w;
+		int x = 0;
+		for (; x + 4 <= w; x += 4) {
+			_mm_storeu_ps(d + x, Max3_SSE2(_mm_loadu_ps(s + x - w), _mm_loadu_ps(s + x), _mm_loadu_ps(s + x + w)));
+		}
+		for (; x < w; ++x) {
+			d[x] = Max3(s[x - w], s[x], s[x + w]);
+		}
+	}
+}
+
+const LogoKernelSet& GetLogoKernelC()
+{
+	static const LogoKernelSet kernel = {
+		"C",
+		DeintY_C<uint8_t>,
+		DeintY_C<uint16_t>,
+		RemoveLogo_C,
+		LogoScore_C,
+		LogoScoreFades_C,
+		Delogo_C<uint8_t>,
+		Delogo_C<uint16_t>,
+		Variance5x5_C,
+		MaxFilter3_C
+	};
+	return kernel;
+}
+
+const LogoKernelSet& GetLogoKernelSSE2()
+{
+	static const LogoKernelSet kernel = {
+		"SSE2",
+		DeintY_SSE2<uint8_t>,
+		DeintY_SSE2<uint16_t>,
+		RemoveLogo_SSE2,
+		LogoScore_SSE2,
+		LogoScoreFades_SSE2,
+		Delogo8_SSE2,
+		Delogo16_SSE2,
+		Variance5x5_SSE2,
+		MaxFilter3_SSE2
+	};
+	return kernel;
+}
+
+const LogoKernelSet& GetLogoKernel()
+{
+	static const LogoKernelSet& kernel =
+		IsAVX512Available() ? GetLogoKernelAVX512() :
+		IsAVX2Available() ? GetLogoKernelAVX2() :
+		GetLogoKernelSSE2();
+	return kernel;
+}
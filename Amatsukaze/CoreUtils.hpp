@@ -10,7 +10,11 @@
 #include "common.h"
 
 #include <string>
+#include <vector>
+#include <new>
+#include <type_traits>
 #include <io.h>
+#include <malloc.h>
 
 #define AMT_MAX_PATH 512
 
@@ -230,6 +234,135 @@ private:
 	}
 };
 
+/** @brief XbhƂ̍Ɨp
+* t[Ƃnew/deleteȂ߁Amۂ̓XbhI܂Ŏg
+* mۂScopePʂŁAScope𔲂ƕԋpiX^bNƓɊmۂ̂Ԃj
+* ȂȂubNǉASԋpꂽƂ1̃ubNɂ܂Ƃ߂̂
+* TCY̊mۂJԂƃq[vmۂ͔ȂȂ
+*/
+class ScratchArena : NonCopyable {
+public:
+	enum {
+		ALIGN = 64, // LbVCɑ
+		MIN_BLOCK_SIZE = 64 * 1024,
+	};
+
+	/** @brief ݂̃Xbh̃A[i */
+	static ScratchArena& current() {
+		thread_local ScratchArena arena;
+		return arena;
+	}
+
+	class Scope : NonCopyable {
+	public:
+		Scope()
+			: arena_(ScratchArena::current())
+			, cur_(arena_.cur_)
+			, pos_(arena_.pos_)
+		{ }
+
+		~Scope() {
+			arena_.release(cur_, pos_);
+		}
+
+		/** @brief ĂȂcountTmہiALIGNɑj */
+		template <typename T>
+		T* alloc(size_t count) {
+			static_assert(std::is_trivial<T>::value, "ScratchArena supports only trivial types");
+			return static_cast<T*>(arena_.allocBytes(sizeof(T) * count));
+		}
+
+	private:
+		ScratchArena& arena_;
+		size_t cur_;
+		size_t pos_;
+	};
+
+	~ScratchArena() {
+		freeBlocks(0);
+	}
+
+	/** @brief ܂łɃq[vmۂ */
+	int getNumHeapAllocs() const {
+		return numHeapAllocs_;
+	}
+
+	/** @brief mۍς݂̃ */
+	size_t getCapacity() const {
+		size_t total = 0;
+		for (const Block& block : blocks_) {
+			total += block.size;
+		}
+		return total;
+	}
+
+private:
+	struct Block {
+		uint8_t* data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks_;
+	size_t cur_; // gp̃ubN
+	size_t pos_; // gp̃ubN̎gpς݃TCY
+	int numHeapAllocs_;
+
+	ScratchArena()
+		: cur_(0)
+		, pos_(0)
+		, numHeapAllocs_(0)
+	{ }
+
+	void* allocBytes(size_t bytes) {
+		while (true) {
+			if (cur_ < blocks_.size()) {
+				size_t start = (pos_ + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+				if (start + bytes <= blocks_[cur_].size) {
+					pos_ = start + bytes;
+					return blocks_[cur_].data + start;
+				}
+				if (cur_ + 1 < blocks_.size() && bytes <= blocks_[cur_ + 1].size) {
+					++cur_;
+					pos_ = 0;
+					continue;
+				}
+				// ̃ubN͎gĂȂ̂Ŏ̂ĂĐVmۂ
+				freeBlocks(cur_ + 1);
+				cur_ = blocks_.size();
+			}
+			pos_ = 0;
+			addBlock(std::max(bytes, std::max((size_t)MIN_BLOCK_SIZE, getCapacity())));
+		}
+	}
+
+	void release(size_t cur, size_t pos) {
+		cur_ = cur;
+		pos_ = pos;
+		if (cur_ == 0 && pos_ == 0 && blocks_.size() > 1) {
+			// Sԋpꂽ̂Ŏ1ubNɎ܂悤ɂ܂Ƃ߂
+			size_t total = getCapacity();
+			freeBlocks(0);
+			addBlock(total);
+		}
+	}
+
+	void addBlock(size_t size) {
+		Block block = { static_cast<uint8_t*>(_aligned_malloc(size, ALIGN)), size };
+		if (block.data == nullptr) {
+			throw std::bad_alloc();
+		}
+		blocks_.push_back(block);
+		++numHeapAllocs_;
+	}
+
+	void freeBlocks(size_t first) {
+		for (size_t i = first; i < blocks_.size(); ++i) {
+			_aligned_free(blocks_[i].data);
+		}
+		blocks_.resize(first);
+	}
+};
+
 #include "StringUtils.hpp"
 
 DWORD GetFullPathNameT(LPCWSTR lpFileName, DWORD nBufferLength, LPWSTR lpBuffer, LPWSTR* lpFilePart) {
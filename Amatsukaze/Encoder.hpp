@@ -69,17 +69,48 @@ public:
 		}
 		buffer.add(MemoryChunk((uint8_t*)frameHeader.data(), frameHeader.size()));
 		int yuv[] = { PLANAR_Y, PLANAR_U, PLANAR_V };
+		bool direct = true;
 		for (int c = 0; c < nc; ++c) {
-			const uint8_t* plane = frame->GetReadPtr(yuv[c]);
-			int pitch = frame->GetPitch(yuv[c]);
-			int height = frame->GetHeight(yuv[c]);
-			int rowsize = frame->GetRowSize(yuv[c]);
-			for (int y = 0; y < height; ++y) {
-				buffer.add(MemoryChunk((uint8_t*)plane + y * pitch, rowsize));
+			if (frame->GetPitch(yuv[c]) != frame->GetRowSize(yuv[c])) {
+				direct = false;
 			}
+		}
+		if (direct) {
+			// Sv[pfBOȂȂ̂Ńt[obt@璼ڏ
+			// Xg[wb_ƃt[wb_1ɂ܂Ƃ߂čŏ̃v[̒Oɏ
 			onWrite(buffer.get());
 			buffer.clear();
+			for (int c = 0; c < nc; ++c) {
+				const uint8_t* plane = frame->GetReadPtr(yuv[c]);
+				int height = frame->GetHeight(yuv[c]);
+				int rowsize = frame->GetRowSize(yuv[c]);
+				onWrite(MemoryChunk((uint8_t*)plane, (size_t)rowsize * height));
+			}
+		}
+		else {
+			// pfBOꍇ1t[obt@ɋl߂1ŏ
+			for (int c = 0; c < nc; ++c) {
+				const uint8_t* plane = frame->GetReadPtr(yuv[c]);
+				int pitch = frame->GetPitch(yuv[c]);
+				int height = frame->GetHeight(yuv[c]);
+				int rowsize = frame->GetRowSize(yuv[c]);
+				for (int y = 0; y < height; ++y) {
+					buffer.add(MemoryChunk((uint8_t*)plane + y * pitch, rowsize));
+				}
+			}
+			onWrite(buffer.get());
+			buffer.clear();
+		}
+	}
+	// Y,U,V̏ɃpfBOȂŋl߂t[͂
+	void inputPackedFrame(MemoryChunk frame) {
+		if (n++ == 0) {
+			buffer.add(MemoryChunk((uint8_t*)header.data(), header.size()));
 		}
+		buffer.add(MemoryChunk((uint8_t*)frameHeader.data(), frameHeader.size()));
+		onWrite(buffer.get());
+		buffer.clear();
+		onWrite(frame);
 	}
 protected:
 	virtual void onWrite(MemoryChunk mc) = 0;
@@ -120,6 +151,15 @@ public:
 		y4mWriter_->inputFrame(frame);
 	}
 
+	void inputPackedFrame(MemoryChunk frame) {
+		y4mWriter_->inputPackedFrame(frame);
+	}
+
+	// y4mXg[̃f[^̂܂ܓ͂iXg[wb_܂߂邱Ɓj
+	void inputData(MemoryChunk mc) {
+		process_->write(mc);
+	}
+
 	void finish() {
 		if (y4mWriter_ != NULL) {
 			process_->finishWrite();
@@ -169,98 +209,420 @@ public:
 		AMTContext&ctx, int numEncodeBufferFrames)
 		: AMTObject(ctx)
 		, thread_(this, numEncodeBufferFrames)
+		, cacheCodec_(nullptr, DeleteUtVideoCodec)
+		, cacheEncoding_(false)
+		, cacheError_(false)
 	{
 		ctx.infoF("obt@Ot[: %d", numEncodeBufferFrames);
 	}
 
+	~AMTFilterVideoEncoder() {
+		if (cacheEncoding_) {
+			cacheCodec_->EncodeEnd();
+		}
+	}
+
+	// encoderOptions: pXƂ̃GR[_
+	// cachePathw肷1pXڂ̃tB^o͂t@CɕۑāA
+	// 2pXڈȍ~̓tB^sɂ̃t@C͂
+	// 8bit 4:2:0UtVideoňkĕۑAȊOy4m̂܂ܕۑ
 	void encode(
 		PClip source, VideoFormat outfmt, const std::vector<double>& timeCodes,
 		const std::vector<tstring>& encoderOptions,
-		IScriptEnvironment* env)
+		IScriptEnvironment* env,
+		const tstring& cachePath = tstring(), bool cacheMmap = false)
 	{
+		std::vector<std::vector<tstring>> passArgs;
+		for (const tstring& args : encoderOptions) {
+			passArgs.push_back(std::vector<tstring>(1, args));
+		}
+		encode(source, outfmt, timeCodes, passArgs, env, cachePath, cacheMmap);
+	}
+
+	// encoderOptions: pXƂɁAɓ͂GR[_̈
+	// 1̃tB^si܂̓LbVǂݍ݁jŕ̃GR[_ɓ͂
+	void encode(
+		PClip source, VideoFormat outfmt, const std::vector<double>& timeCodes,
+		const std::vector<std::vector<tstring>>& encoderOptions,
+		IScriptEnvironment* env,
+		const tstring& cachePath = tstring(), bool cacheMmap = false)
+	{
+		init(source, outfmt, timeCodes);
+
+		int npass = (int)encoderOptions.size();
+		bool useCache = (cachePath.size() > 0 && npass > 1 && checkCacheSpace(cachePath));
+		for (int i = 0; i < npass; ++i) {
+			ctx.infoF("%d/%dpX GR[hJn GR[_: %d \t[: %d",
+				i + 1, npass, (int)encoderOptions[i].size(), vi_.num_frames);
+			if (useCache && i > 0) {
+				encodeFromCache(encoderOptions[i], cachePath, cacheMmap);
+			}
+			else {
+				encodeFromFilter(source, encoderOptions[i], env,
+					useCache ? cachePath : tstring());
+				// ۑɎsȍ~̃pXtB^s
+				useCache = useCache && !cacheError_;
+			}
+		}
+	}
+
+private:
+
+	// t[Ƃ̎󂯓n̂ŃOobt@łg
+	class SpDataPumpThread : public SPSCDataPumpThread<PVideoFrame, true> {
+	public:
+		SpDataPumpThread(AMTFilterVideoEncoder* this_, int bufferingFrames)
+			: SPSCDataPumpThread(bufferingFrames)
+			, this_(this_)
+		{ }
+	protected:
+		virtual void OnDataReceived(PVideoFrame&& data) {
+			this_->writer_->inputFrame(data);
+			if (this_->cacheFile_ != nullptr) {
+				this_->writeLosslessCache(data);
+			}
+		}
+	private:
+		AMTFilterVideoEncoder * this_;
+	};
+
+	// y4m1񂾂đSGR[_y4mLbVɏ
+	class CacheWriter : public Y4MWriter {
+	public:
+		CacheWriter(AMTFilterVideoEncoder* this_, VideoInfo vi, VideoFormat fmt)
+			: Y4MWriter(vi, fmt)
+			, this_(this_)
+		{ }
+	protected:
+		virtual void onWrite(MemoryChunk mc) {
+			for (auto& encoder : this_->encoders_) {
+				encoder->inputData(mc);
+			}
+			if (this_->cache_ != nullptr) {
+				this_->writeY4MCache(mc);
+			}
+		}
+	private:
+		AMTFilterVideoEncoder * this_;
+	};
+
+	enum {
+		CACHE_BUFSIZE = 16 * 1024 * 1024,
+		CACHE_NUM_BUFFERS = 4,
+	};
+
+	VideoInfo vi_;
+	VideoFormat outfmt_;
+	std::vector<std::unique_ptr<Y4MEncodeWriter>> encoders_;
+	std::unique_ptr<CacheWriter> writer_;
+
+	// y4mLbV
+	std::unique_ptr<AsyncFileWriter> cache_;
+
+	// UtVideoLbV
+	CCodecPointer cacheCodec_;
+	bool cacheEncoding_;
+	std::unique_ptr<LosslessVideoFile> cacheFile_;
+	std::unique_ptr<uint8_t[]> cacheRaw_;
+	std::unique_ptr<uint8_t[]> cacheCoded_;
+
+	bool cacheError_;
+
+	SpDataPumpThread thread_;
+
+	void init(PClip source, VideoFormat outfmt, const std::vector<double>& timeCodes) {
 		vi_ = source->GetVideoInfo();
 		outfmt_ = outfmt;
 
-		int bufsize = outfmt_.width * outfmt_.height * 3;
-
 		if (timeCodes.size() > 0 && vi_.num_frames != timeCodes.size() - 1)
 		{
 			THROW(RuntimeException, "t[܂");
 		}
+	}
 
-		int npass = (int)encoderOptions.size();
-		for (int i = 0; i < npass; ++i) {
-			ctx.infoF("%d/%dpX GR[hJn \t[: %d", i + 1, npass, vi_.num_frames);
-
-			const tstring& args = encoderOptions[i];
-
+	void startEncoders(const std::vector<tstring>& encoderArgs) {
+		for (const tstring& args : encoderArgs) {
 			ctx.info("[GR[_N]");
 			ctx.infoF("%s", args);
+			encoders_.emplace_back(new Y4MEncodeWriter(ctx, args, vi_, outfmt_));
+		}
+	}
+
+	// SGR[_IiG[ĂSIĂŏ̃G[𓊂j
+	void finishEncoders() {
+		std::exception_ptr error;
+		for (auto& encoder : encoders_) {
+			try {
+				encoder->finish();
+			}
+			catch (...) {
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+
+	void inputAllEncoders(MemoryChunk mc) {
+		for (auto& encoder : encoders_) {
+			encoder->inputData(mc);
+		}
+	}
+
+	bool isLosslessCache() const {
+		return vi_.Is420() && vi_.BitsPerComponent() == 8;
+	}
 
-			// 
-			encoder_ = std::unique_ptr<Y4MEncodeWriter>(new Y4MEncodeWriter(ctx, args, vi_, outfmt_));
+	size_t packedFrameSize() const {
+		size_t size = (size_t)vi_.width * vi_.height;
+		if (!vi_.IsY()) {
+			size += 2 * (size_t)(vi_.width >> vi_.GetPlaneWidthSubsampling(PLANAR_U)) *
+				(vi_.height >> vi_.GetPlaneHeightSubsampling(PLANAR_U));
+		}
+		return size * vi_.ComponentSize();
+	}
+
+	// LbVu邾̋󂫂邩
+	bool checkCacheSpace(const tstring& cachePath) {
+		// y4m͂قڐm UtVideo͈kȂ̂Ŗk̔Ōς
+		double required = (double)packedFrameSize() * vi_.num_frames;
+		if (isLosslessCache()) {
+			required *= 0.5;
+		}
+		int64_t freeSpace = GetFreeDiskSpace(cachePath);
+		if (freeSpace >= 0 && freeSpace < required) {
+			ctx.warnF("ꎞtH_̋󂫂Ȃ̂ŃtB^o͂ۑ܂iKv: %.1fGB : %.1fGBj",
+				required / (1024.0 * 1024.0 * 1024.0), freeSpace / (1024.0 * 1024.0 * 1024.0));
+			return false;
+		}
+		return true;
+	}
 
-			Stopwatch sw;
-			// GR[hXbhJn
-			thread_.start();
-			sw.start();
+	void openCache(const tstring& cachePath) {
+		cacheError_ = false;
+		if (isLosslessCache()) {
+			ctx.infoF("tB^o͂ۑ(UtVideo): %s", cachePath);
+			int w = vi_.width, h = vi_.height;
+			cacheCodec_ = make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze"));
+			size_t extraSize = cacheCodec_->EncodeGetExtraDataSize();
+			std::vector<uint8_t> extra(extraSize);
+			if (cacheCodec_->EncodeGetExtraData(extra.data(), extraSize, UTVF_YV12, w, h)) {
+				THROW(RuntimeException, "failed to EncodeGetExtraData (UtVideo)");
+			}
+			if (cacheCodec_->EncodeBegin(UTVF_YV12, w, h, CBGROSSWIDTH_WINDOWS)) {
+				THROW(RuntimeException, "failed to EncodeBegin (UtVideo)");
+			}
+			cacheEncoding_ = true;
+			size_t codedSize = cacheCodec_->EncodeGetOutputSize(UTVF_YV12, w, h);
+			cacheCoded_ = std::unique_ptr<uint8_t[]>(new uint8_t[codedSize]);
+			cacheRaw_ = std::unique_ptr<uint8_t[]>(new uint8_t[packedFrameSize()]);
+			cacheFile_ = std::unique_ptr<LosslessVideoFile>(new LosslessVideoFile(ctx, cachePath, _T("wb")));
+			cacheFile_->writeHeader(w, h, vi_.num_frames, extra);
+		}
+		else {
+			ctx.infoF("tB^o͂ۑ(y4m): %s", cachePath);
+			cache_ = std::unique_ptr<AsyncFileWriter>(
+				new AsyncFileWriter(cachePath, CACHE_BUFSIZE, CACHE_NUM_BUFFERS));
+		}
+	}
 
-			bool error = false;
+	// ۑɎsĂGR[h͑
+	void onCacheError(const Exception& e) {
+		ctx.warnF("tB^o͂̕ۑɎŝňȍ~̃pXtB^s܂: %s", e.message());
+		cacheError_ = true;
+	}
 
+	void writeY4MCache(MemoryChunk mc) {
+		try {
+			cache_->write(mc);
+		}
+		catch (const Exception& e) {
+			onCacheError(e);
+			cache_ = nullptr;
+		}
+	}
+
+	void writeLosslessCache(PVideoFrame& frame) {
+		try {
+			CopyYV12(cacheRaw_.get(), frame, vi_.width, vi_.height);
+			bool keyFrame = false;
+			size_t codedSize = cacheCodec_->EncodeFrame(cacheCoded_.get(), &keyFrame, cacheRaw_.get());
+			cacheFile_->writeFrame(cacheCoded_.get(), (int)codedSize);
+		}
+		catch (const Exception& e) {
+			onCacheError(e);
+			cacheFile_ = nullptr;
+		}
+	}
+
+	void closeCache(const tstring& cachePath) {
+		if (cache_ != nullptr) {
 			try {
-				// GR[h
-				for (int i = 0; i < vi_.num_frames; ++i) {
-					auto frame = source->GetFrame(i, env);
-					thread_.put(std::unique_ptr<PVideoFrame>(new PVideoFrame(frame)), 1);
-				}
+				cache_->close();
 			}
-			catch (const AvisynthError& avserror) {
-				ctx.errorF("AvisynthtB^ŃG[: %s", avserror.msg);
-				error = true;
+			catch (const Exception& e) {
+				onCacheError(e);
 			}
-			catch (Exception&) {
-				error = true;
+			cache_ = nullptr;
+		}
+		if (cacheEncoding_) {
+			cacheCodec_->EncodeEnd();
+			cacheEncoding_ = false;
+		}
+		cacheFile_ = nullptr;
+		cacheCodec_ = nullptr;
+		cacheRaw_ = nullptr;
+		cacheCoded_ = nullptr;
+		if (cacheError_) {
+			// ̃t@C͑傫̂ŏĂ
+			removeT(cachePath.c_str());
+		}
+	}
+
+	void encodeFromFilter(PClip source, const std::vector<tstring>& encoderArgs,
+		IScriptEnvironment* env, const tstring& cachePath)
+	{
+		// 
+		startEncoders(encoderArgs);
+		if (cachePath.size() > 0) {
+			try {
+				openCache(cachePath);
 			}
+			catch (const Exception& e) {
+				onCacheError(e);
+				closeCache(cachePath);
+			}
+		}
+		writer_ = std::unique_ptr<CacheWriter>(new CacheWriter(this, vi_, outfmt_));
 
-			// GR[hXbhIĎɈp
-			thread_.join();
+		Stopwatch sw;
+		// GR[hXbhJn
+		thread_.start();
+		sw.start();
 
-			// ct[
-			encoder_->finish();
+		bool error = false;
 
-			if (error) {
-				THROW(RuntimeException, "GR[hɕsȃG[");
+		try {
+			// GR[h
+			for (int i = 0; i < vi_.num_frames; ++i) {
+				thread_.put(source->GetFrame(i, env), 1);
 			}
+		}
+		catch (const AvisynthError& avserror) {
+			ctx.errorF("AvisynthtB^ŃG[: %s", avserror.msg);
+			error = true;
+		}
+		catch (Exception&) {
+			error = true;
+		}
 
-			encoder_ = nullptr;
-			sw.stop();
+		// GR[hXbhIĎɈp
+		thread_.join();
+
+		// ct[
+		if (cachePath.size() > 0) {
+			closeCache(cachePath);
+		}
+		finishEncoders();
 
-			double prod, cons; thread_.getTotalWait(prod, cons);
-			ctx.infoF("Total: %.2fs, FilterWait: %.2fs, EncoderWait: %.2fs", sw.getTotal(), prod, cons);
+		if (error) {
+			THROW(RuntimeException, "GR[hɕsȃG[");
 		}
+
+		encoders_.clear();
+		writer_ = nullptr;
+		sw.stop();
+
+		double prod, cons; thread_.getTotalWait(prod, cons);
+		ctx.infoF("Total: %.2fs, FilterWait: %.2fs, EncoderWait: %.2fs", sw.getTotal(), prod, cons);
 	}
 
-private:
+	// ۑtB^o͂GR[_ɓ͂
+	void encodeFromCache(const std::vector<tstring>& encoderArgs, const tstring& cachePath, bool mmap)
+	{
+		startEncoders(encoderArgs);
+		// }bvł̂y4m̂
+		mmap = mmap && !isLosslessCache();
+		ctx.infoF("tB^o͂ǂݍ: %s%s", cachePath, mmap ? " (}bv)" : "");
 
-	class SpDataPumpThread : public DataPumpThread<std::unique_ptr<PVideoFrame>, true> {
-	public:
-		SpDataPumpThread(AMTFilterVideoEncoder* this_, int bufferingFrames)
-			: DataPumpThread(bufferingFrames)
-			, this_(this_)
-		{ }
-	protected:
-		virtual void OnDataReceived(std::unique_ptr<PVideoFrame>&& data) {
-			this_->encoder_->inputFrame(*data);
+		Stopwatch sw;
+		sw.start();
+
+		bool error = false;
+
+		try {
+			if (isLosslessCache()) {
+				readLosslessCache(cachePath);
+			}
+			else if (mmap) {
+				MappedFile file(cachePath);
+				MemoryChunk data = file.get();
+				for (size_t offset = 0; offset < data.length; offset += CACHE_BUFSIZE) {
+					inputAllEncoders(MemoryChunk(data.data + offset,
+						std::min<size_t>(CACHE_BUFSIZE, data.length - offset)));
+				}
+			}
+			else {
+				AsyncFileReader reader(cachePath, CACHE_BUFSIZE, CACHE_NUM_BUFFERS);
+				MemoryChunk mc;
+				while (reader.next(mc)) {
+					inputAllEncoders(mc);
+				}
+			}
+		}
+		catch (Exception&) {
+			error = true;
 		}
-	private:
-		AMTFilterVideoEncoder * this_;
-	};
 
-	VideoInfo vi_;
-	VideoFormat outfmt_;
-	std::unique_ptr<Y4MEncodeWriter> encoder_;
+		finishEncoders();
 
-	SpDataPumpThread thread_;
+		if (error) {
+			THROW(RuntimeException, "GR[hɕsȃG[");
+		}
+
+		encoders_.clear();
+		sw.stop();
+
+		ctx.infoF("Total: %.2fs", sw.getTotal());
+	}
+
+	void readLosslessCache(const tstring& cachePath)
+	{
+		LosslessVideoFile file(ctx, cachePath, _T("rb"));
+		file.readHeader();
+		int w = file.getWidth(), h = file.getHeight();
+		if (w != vi_.width || h != vi_.height || file.getNumFrames() != vi_.num_frames) {
+			THROW(FormatException, "tB^o͂̃LbVsł");
+		}
+		auto codec = make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze"));
+		const auto& extra = file.getExtra();
+		if (codec->DecodeBegin(UTVF_YV12, w, h, CBGROSSWIDTH_WINDOWS, extra.data(), (int)extra.size())) {
+			THROW(RuntimeException, "failed to DecodeBegin (UtVideo)");
+		}
+		size_t frameSize = packedFrameSize();
+		size_t codedSize = codec->EncodeGetOutputSize(UTVF_YV12, w, h);
+		std::unique_ptr<uint8_t[]> coded(new uint8_t[codedSize]);
+		std::unique_ptr<uint8_t[]> raw(new uint8_t[frameSize]);
+		try {
+			for (int i = 0; i < vi_.num_frames; ++i) {
+				file.readFrame(i, coded.get());
+				if (codec->DecodeFrame(raw.get(), coded.get()) != frameSize) {
+					THROW(RuntimeException, "failed to DecodeFrame (UtVideo)");
+				}
+				for (auto& encoder : encoders_) {
+					encoder->inputPackedFrame(MemoryChunk(raw.get(), frameSize));
+				}
+			}
+		}
+		catch (...) {
+			codec->DecodeEnd();
+			throw;
+		}
+		codec->DecodeEnd();
+	}
 };
 
 class AMTSimpleVideoEncoder : public AMTObject {
@@ -15,6 +15,7 @@
 #include "ReaderWriterFFmpeg.hpp"
 #include "TranscodeSetting.hpp"
 #include "StreamReform.hpp"
+#include "AudioEncoder.hpp"
 #include "AMTSource.hpp"
 #include "InterProcessComm.hpp"
 
@@ -450,20 +451,30 @@ private:
 		sb.append("\tif(mt) { Prefetch(1, 4) }\n");
 
 		int numEraseLogo = 0;
-		auto eraseLogo = [&](const tstring& logopath, const tstring& logoFramePath, bool forceEnable) {
+		auto eraseLogo = [&](const tstring& logopath, const tstring& logoFramePath,
+			const tstring& analysisPath, bool forceEnable) {
 			if (forceEnable || File::exists(logoFramePath)) {
 				sb.append("\tlogo = \"%s\"\n", logopath);
-				sb.append("\tAMTEraseLogo(AMTAnalyzeLogo(logo), logo, \"%s\", maxfade=%d)\n",
-					logoFramePath, setting_.getMaxFadeLength());
+				if (setting_.isReuseLogoAnalysis() && File::exists(analysisPath)) {
+					// CM͎̉͌ʂĝAMTAnalyzeLogo͕svianalyzeclip͎QƂȂj
+					sb.append("\tAMTEraseLogo(last, last, logo, \"%s\", maxfade=%d, analysis=\"%s\")\n",
+						logoFramePath, setting_.getMaxFadeLength(), analysisPath);
+				}
+				else {
+					sb.append("\tAMTEraseLogo(AMTAnalyzeLogo(logo), logo, \"%s\", maxfade=%d)\n",
+						logoFramePath, setting_.getMaxFadeLength());
+				}
 				++numEraseLogo;
 			}
 		};
 		if (setting_.isNoDelogo() == false && logopath.size() > 0) {
-			eraseLogo(logopath, setting_.getTmpLogoFramePath(key.video), true);
+			eraseLogo(logopath, setting_.getTmpLogoFramePath(key.video),
+				setting_.getTmpLogoAnalysisPath(key.video), true);
 		}
 		const auto& eraseLogoPath = setting_.getEraseLogoPath();
 		for (int i = 0; i < (int)eraseLogoPath.size(); ++i) {
-			eraseLogo(eraseLogoPath[i], setting_.getTmpLogoFramePath(key.video, i), false);
+			eraseLogo(eraseLogoPath[i], setting_.getTmpLogoFramePath(key.video, i),
+				setting_.getTmpLogoAnalysisPath(key.video, i), false);
 		}
 		if (numEraseLogo > 0) {
 			sb.append("\tif(mt) { Prefetch(1, 4) }\n");
@@ -675,6 +686,101 @@ public:
 	}
 };
 
+// [start,end)|values[i] - avg| * counts[i]̍v߂
+// l̏ʂŕZOg؂ɐ擪1vfǉłSĎĂiijA
+// 2̔ł̍avgȉ̒ľƍv߂̂ŁA1̌vZO(log l̎ސ)
+class AbsDiffSum {
+public:
+	AbsDiffSum(const std::vector<double>& values, const std::vector<int>& counts)
+		: sorted_(values)
+		, prefixSum_(values.size() + 1)
+		, prefixCount_(values.size() + 1)
+		, roots_(values.size() + 1)
+	{
+		std::sort(sorted_.begin(), sorted_.end());
+		sorted_.erase(std::unique(sorted_.begin(), sorted_.end()), sorted_.end());
+		// 1vfǉƂɖ؂̍̃m[h
+		int depth = 1;
+		while ((1 << (depth - 1)) < (int)sorted_.size()) ++depth;
+		nodes_.reserve(values.size() * depth + 1);
+		// 0Ԃ͋̃m[h
+		nodes_.push_back(Node());
+		prefixSum_[0] = 0;
+		prefixCount_[0] = 0;
+		roots_[0] = 0;
+		for (int i = 0; i < (int)values.size(); ++i) {
+			int rank = (int)(std::lower_bound(sorted_.begin(), sorted_.end(), values[i]) - sorted_.begin());
+			double sum = values[i] * counts[i];
+			prefixSum_[i + 1] = prefixSum_[i] + sum;
+			prefixCount_[i + 1] = prefixCount_[i] + counts[i];
+			roots_[i + 1] = insert(roots_[i], 0, (int)sorted_.size(), rank, counts[i], sum);
+		}
+	}
+
+	double operator()(int start, int end, double avg) const {
+		// avgȉ̒ľƍv
+		int rank = (int)(std::upper_bound(sorted_.begin(), sorted_.end(), avg) - sorted_.begin());
+		int a = roots_[end], b = roots_[start];
+		int lo = 0, hi = (int)sorted_.size();
+		int cnt = 0;
+		double sum = 0;
+		while (rank > lo) {
+			if (rank >= hi) {
+				cnt += nodes_[a].cnt - nodes_[b].cnt;
+				sum += nodes_[a].sum - nodes_[b].sum;
+				break;
+			}
+			int mid = (lo + hi) / 2;
+			if (rank <= mid) {
+				a = nodes_[a].left; b = nodes_[b].left;
+				hi = mid;
+			}
+			else {
+				const Node& la = nodes_[nodes_[a].left];
+				const Node& lb = nodes_[nodes_[b].left];
+				cnt += la.cnt - lb.cnt;
+				sum += la.sum - lb.sum;
+				a = nodes_[a].right; b = nodes_[b].right;
+				lo = mid;
+			}
+		}
+		int totalCount = prefixCount_[end] - prefixCount_[start];
+		double totalSum = prefixSum_[end] - prefixSum_[start];
+		return (avg * cnt - sum) + ((totalSum - sum) - avg * (totalCount - cnt));
+	}
+
+private:
+	struct Node {
+		int left, right;
+		int cnt;
+		double sum;
+	};
+	std::vector<double> sorted_;
+	std::vector<double> prefixSum_;
+	std::vector<int> prefixCount_;
+	std::vector<int> roots_;
+	std::vector<Node> nodes_;
+
+	int insert(int prev, int lo, int hi, int rank, int cnt, double sum) {
+		int node = (int)nodes_.size();
+		nodes_.push_back(nodes_[prev]);
+		nodes_[node].cnt += cnt;
+		nodes_[node].sum += sum;
+		if (hi - lo > 1) {
+			int mid = (lo + hi) / 2;
+			if (rank < mid) {
+				int child = insert(nodes_[prev].left, lo, mid, rank, cnt, sum);
+				nodes_[node].left = child;
+			}
+			else {
+				int child = insert(nodes_[prev].right, mid, hi, rank, cnt, sum);
+				nodes_[node].right = child;
+			}
+		}
+		return node;
+	}
+};
+
 // VFRł̃[gRg[
 // VFR^C~OCM][][ƃrbg[g쐬
 std::vector<BitrateZone> MakeVFRBitrateZones(const std::vector<double>& timeCodes,
@@ -684,7 +790,8 @@ std::vector<BitrateZone> MakeVFRBitrateZones(const std::vector<double>& timeCode
 	enum {
 		UNIT_FRAMES = 8,
 		HARD_ZONE_LIMIT = 1000, // ][1000
-		TARGET_ZONES_PER_HOUR = 30 // ڕW][1Ԃ30
+		TARGET_ZONES_PER_HOUR = 30, // ڕW][1Ԃ30
+		LINEAR_COST_UNITS = 4096 // 蒷Ԃ̃RXg͖؂ŌvZ
 	};
 	struct Block {
 		int index;   // ubN擪UNITAhX
@@ -731,37 +838,57 @@ std::vector<BitrateZone> MakeVFRBitrateZones(const std::vector<double>& timeCode
 	// Ōɔԕu
 	blocks.push_back(Block{ (int)units.size(), -1, 0, 0 });
 
-	auto sumDiff = [&](int start, int end, double avg) {
-		double diff = 0;
-		for (int i = start; i < end; ++i) {
-			diff += std::abs(units[i] - avg);
+	// AĂubN̋E͍ŏ̃ubN̋Ê܂܂Ȃ̂ŁA
+	// Ԃ̃RXg͍ŏ̃ubNPʂō؂ŌvZ
+	// iAiŒԂoĂ܂ł͍Ȃj
+	std::vector<double> blockValues;
+	std::vector<int> blockLengths;
+	for (int i = 0; i + 1 < (int)blocks.size(); ++i) {
+		blockValues.push_back(blocks[i].avg);
+		blockLengths.push_back(blocks[i + 1].index - blocks[i].index);
+	}
+	std::unique_ptr<AbsDiffSum> costTree;
+
+	// ubNstartBlockendBlock̎O܂ł̃RXg
+	auto sumDiff = [&](int startBlock, int endBlock, double avg) {
+		int start = blocks[startBlock].index;
+		int end = blocks[endBlock].index;
+		if (end - start <= LINEAR_COST_UNITS) {
+			double diff = 0;
+			for (int i = start; i < end; ++i) {
+				diff += std::abs(units[i] - avg);
+			}
+			return diff;
+		}
+		if (costTree == nullptr) {
+			costTree = std::unique_ptr<AbsDiffSum>(new AbsDiffSum(blockValues, blockLengths));
 		}
-		return diff;
+		return (*costTree)(startBlock, endBlock, avg);
 	};
 
-	auto calcCost = [&](Block& cur, const Block&  next) {
+	// ubNbƌ̃ubNAƂ̒ǉRXgvZ
+	auto calcCost = [&](int b) {
+		auto& cur = blocks[b];
+		const auto& next = blocks[cur.next];
 		int start = cur.index;
 		int mid = next.index;
 		int end = blocks[next.next].index;
 		// ݂̃RXg
-
-		double cur_cost = sumDiff(start, mid, cur.avg);
-		double next_cost = sumDiff(mid, end, next.avg);
+		double cur_cost = sumDiff(b, cur.next, cur.avg);
+		double next_cost = sumDiff(cur.next, next.next, next.avg);
 		// A̕σrbg[g
 		double avg2 = (cur.avg * (mid - start) + next.avg * (end - mid)) / (end - start);
 		// ÃRXg
-		double cost2 = sumDiff(start, end, avg2);
+		double cost2 = sumDiff(b, next.next, avg2);
 		// ǉRXg
 		cur.cost = cost2 - (cur_cost + next_cost);
 	};
 
 	// AǉRXgvZ
 	for (int i = 0; blocks[i].index < (int)units.size(); i = blocks[i].next) {
-		auto& cur = blocks[i];
-		auto& next = blocks[cur.next];
 		// ̃ubN݂
-		if (next.index < (int)units.size()) {
-			calcCost(cur, next);
+		if (blocks[blocks[i].next].index < (int)units.size()) {
+			calcCost(i);
 		}
 	}
 
@@ -806,7 +933,7 @@ std::vector<BitrateZone> MakeVFRBitrateZones(const std::vector<double>& timeCode
 			auto& nextnext = blocks[cur.next];
 			if (nextnext.index < (int)units.size()) {
 				// A̒ǉRXgvZ
-				calcCost(cur, nextnext);
+				calcCost(idx);
 				// ēxq[vɒǉ
 				indices[heapSize] = idx;
 				std::push_heap(indices.begin(), indices.begin() + (++heapSize), comp);
@@ -618,8 +618,10 @@ public:
 
 
 class H264VideoParser : public AMTObject, public IVideoParser {
+protected:
 	struct NalUnit {
-		int offset;
+		uint8_t header; // nal_unit_typeȂǂ擪1oCg
+		int offset; // bufferł̈ʒuig͂NALLj
 		int length; // rbsp_trailing_bits
 	};
 public:
@@ -664,13 +666,18 @@ public:
 
 		for (int i = 0; i < numNalUnits; ++i) {
 			NalUnit nalUnit = nalUnits[i];
-			int payloadLength = nalUnit.length;
-			uint8_t* ptr = buffer.ptr() + nalUnit.offset;
+			if (nalUnit.length == 0) {
+				// ĝȂNAL
+				continue;
+			}
+			int payloadLength = nalUnit.length - 1;
 
-			uint8_t nal_ref_idc = bsm(ptr[0], 5, 2);
-			uint8_t nal_unit_type = bsm(ptr[0], 0, 5);
+			uint8_t nal_ref_idc = bsm(nalUnit.header, 5, 2);
+			uint8_t nal_unit_type = bsm(nalUnit.header, 0, 5);
 
-			++ptr; --payloadLength;
+			// gbufferɂ͉̂͂NAL
+			uint8_t* ptr = isParsedNalType(nal_unit_type)
+				? buffer.ptr() + nalUnit.offset + 1 : nullptr;
 
 			switch (nal_unit_type) {
 			case 1: // IDRȊÕsN`̃XCX
@@ -842,10 +849,119 @@ public:
 		return info.size() > 0;
 	}
 
-private:
+protected:
 	AutoBuffer buffer;
 	std::vector<NalUnit> nalUnits;
 
+	// g͂NALiSEI,SPS,PPS,AUf~^j
+	static bool isParsedNalType(int nal_unit_type) {
+		return nal_unit_type >= 6 && nal_unit_type <= 9;
+	}
+
+	// NALɕnalUnitsɓ
+	// XCXf[^͒gȂ̂ŁAG~[Vh~oCg߂
+	// ͂NALG~[Vh~oCgbufferɃRs[
+	virtual void storeBuffer(MemoryChunk frame) {
+		buffer.clear();
+		nalUnits.clear();
+		startCodes.clear();
+		escapes.clear();
+
+		const uint8_t* data = frame.data;
+		const int length = (int)frame.length;
+
+		// 00 00 01iX^[gR[hj00 00 03iG~[Vh~j
+		// Ō̃oCg̈ʒu񋓂B00memchrł܂Ƃ߂ĒT
+		const uint8_t* end = data + length - 2;
+		for (const uint8_t* p = data; p < end; ) {
+			p = (const uint8_t*)memchr(p, 0, end - p);
+			if (p == nullptr) {
+				break;
+			}
+			if (p[1] != 0) {
+				p += 2;
+			}
+			else if (p[2] == 0) {
+				++p;
+			}
+			else {
+				if (p[2] == 1) {
+					startCodes.push_back((int)(p + 2 - data));
+				}
+				else if (p[2] == 3) {
+					escapes.push_back((int)(p + 2 - data));
+				}
+				p += 3;
+			}
+		}
+
+		int numEscapes = (int)escapes.size();
+		int escIdx = 0;
+		int numUnits = (int)startCodes.size() + 1;
+		for (int u = 0; u < numUnits; ++u) {
+			// jbg͈̔ [unitStart,unitEnd)
+			int unitStart = (u == 0) ? 0 : startCodes[u - 1] + 1;
+			int unitEnd = (u == numUnits - 1) ? length : startCodes[u];
+			int escBegin = escIdx;
+			while (escIdx < numEscapes && escapes[escIdx] < unitEnd) {
+				++escIdx;
+			}
+
+			// Ō0łȂoCgTiG~[Vh~oCg͏j
+			// 擪2oCg͕Kf[^ƂĈ
+			int lower = std::max(unitStart, 2);
+			int lastNonZero = unitEnd - 1;
+			int e = escIdx - 1;
+			for (; lastNonZero >= lower; --lastNonZero) {
+				if (e >= escBegin && escapes[e] == lastNonZero) {
+					--e;
+				}
+				else if (data[lastNonZero] != 0) {
+					break;
+				}
+			}
+			if (lastNonZero < lower) {
+				// ĝȂNAL
+				continue;
+			}
+
+			NalUnit nal;
+			nal.header = data[unitStart];
+			nal.offset = 0;
+			nal.length = (lastNonZero + 1 - unitStart) - (e + 1 - escBegin);
+			if (data[lastNonZero] == 0x80) {
+				// rbsp_stop_one_bitȂoCg͍
+				--nal.length;
+			}
+			else if (lastNonZero == unitStart) {
+				// 擪oCgȂꍇ͂rbsp_stop_one_bit菜
+				nal.header &= nal.header - 1;
+			}
+
+			if (isParsedNalType(bsm(nal.header, 0, 5))) {
+				nal.offset = (int)buffer.size();
+				int pos = unitStart;
+				for (int i = escBegin; i <= e; ++i) {
+					buffer.add(MemoryChunk((uint8_t*)data + pos, escapes[i] - pos));
+					pos = escapes[i] + 1;
+				}
+				buffer.add(MemoryChunk((uint8_t*)data + pos, lastNonZero + 1 - pos));
+				// rbsp_stop_one_bit菜
+				uint8_t& lastByte = buffer.ptr()[buffer.size() - 1];
+				if (lastByte != 0x80) {
+					lastByte &= lastByte - 1;
+				}
+			}
+
+			nalUnits.push_back(nal);
+		}
+	}
+
+private:
+	// storeBuffer̍Ɨp
+	std::vector<int> startCodes;
+	std::vector<int> escapes;
+
 	// O beffering period  DTS;
 	int64_t beffering_period_DTS;
 
@@ -872,57 +988,4 @@ private:
 			break;
 		}
 	}
-
-	void pushNalUnit(int unitStart, int lastNonZero) {
-		if (lastNonZero > 0) {
-			NalUnit nal;
-			nal.offset = unitStart;
-			// rbsp_stop_one_bit菜
-			uint8_t& lastByte = buffer.ptr()[lastNonZero - 1];
-			if (lastByte == 0x80) {
-				// yC[h͂̃oCgɂ͂Ȃ̂1oCg
-				--lastNonZero;
-			}
-			else {
-				lastByte &= lastByte - 1;
-			}
-			nal.length = lastNonZero - unitStart;
-			nalUnits.push_back(nal);
-		}
-	}
-
-	void storeBuffer(MemoryChunk frame) {
-		buffer.clear();
-		nalUnits.clear();
-		buffer.add(MemoryChunk(frame.data, 2));
-		int32_t n3bytes = (frame.data[0] << 8) | frame.data[1];
-		int unitStart = 0;
-		int lastNonZero = 0;
-		int unitStartOrig = 0;
-		int lastNonZeroOrig = 0;
-		for (int i = 2; i < (int)frame.length; ++i) {
-			uint8_t inByte = frame.data[i];
-			n3bytes = ((n3bytes & 0xFFFF) << 8) | inByte;
-			if (n3bytes == 0x03) {
-				// skip one byte
-				//PRINTF("Skip one byte (H264 NAL)\n");
-			}
-			else {
-				buffer.add(inByte);
-				int k = (int)buffer.size();
-
-				if (n3bytes == 0x01) {
-					// start code prefix
-					pushNalUnit(unitStart, lastNonZero);
-					unitStart = k;
-					unitStartOrig = i;
-				}
-				if (inByte) {
-					lastNonZero = k;
-					lastNonZeroOrig = i;
-				}
-			}
-		}
-		pushNalUnit(unitStart, lastNonZero);
-	}
 };
@@ -16,6 +16,7 @@
 #include "AMTLogo.hpp"
 #include "TsInfo.hpp"
 #include "TextOut.h"
+#include "ProcessThread.hpp"
 
 #include <cmath>
 #include <numeric>
@@ -40,8 +41,9 @@ float CalcCorrelation5x5(const float* k, const float* Y, int x, int y, int w, fl
 	return sum;
 }
 
+#include "ComputeKernel.h"
+
 // ComputeKernel.cpp
-bool IsAVXAvailable();
 float CalcCorrelation5x5_AVX(const float* k, const float* Y, int x, int y, int w, float* pavg);
 
 #if 0
@@ -78,6 +80,13 @@ class LogoDataParam : public LogoData
 	int maskpixels;
 	float blackScore;
 
+	// 評価用（着目点ごとにSIMDで処理できるようにタップごとに並べ替えたもの）
+	int numPoints;
+	int kstride;
+	std::unique_ptr<int[]> offsets;
+	std::unique_ptr<float[]> kernelsT;
+	const LogoKernelSet* kernel;
+
 	float(*pCalcCorrelation5x5)(const float* k, const float* Y, int x, int y, int w, float* pavg);
 public:
 	LogoDataParam() { }
@@ -121,9 +130,11 @@ public:
 		const float corrLowerLimit = 0.2f;
 
 		pCalcCorrelation5x5 = IsAVXAvailable() ? CalcCorrelation5x5_AVX : CalcCorrelation5x5;
+		kernel = &GetLogoKernel();
 
 		int YSize = w * h;
-		auto memWork = std::unique_ptr<float[]>(new float[YSize * CLEN + 8]);
+		ScratchArena::Scope scratch;
+		float* memWork = scratch.alloc<float>(YSize * CLEN + 8);
 
 		// 各単色背景にロゴを乗せる
 		for (int c = 0; c < CLEN; ++c) {
@@ -151,18 +162,13 @@ public:
 			 // 画素値の分散の大きい順にmaskratio割合のピクセルを着目点とする
 		std::vector<std::pair<float, int>> variance(YSize);
 		// 各ピクセルの分散を計算（計算されていないところはゼロ初期化されてる）
-		for (int y = 2; y < h - 2; ++y) {
-			for (int x = 2; x < w - 2; ++x) {
-				// 真ん中の色を取る
-				float *slice = &memWork[(CLEN >> 1) * YSize];
-				float k[KLEN];
-				makeKernel(k, slice, x, y, w);
-				variance[x + y * w].first = std::accumulate(k, k + KLEN, 0.0f,
-					[](float sum, float val) { return sum + val * val; });
-			}
-		}
+		// 真ん中の色を取る
+		float* varianceY = scratch.alloc<float>(YSize);
+		std::fill_n(varianceY, YSize, 0.0f);
+		kernel->Variance5x5(varianceY, &memWork[(CLEN >> 1) * YSize], w, h);
 		// ピクセルインデックスを生成
 		for (int i = 0; i < YSize; ++i) {
+			variance[i].first = varianceY[i];
 			variance[i].second = i;
 		}
 		// 降順ソート
@@ -190,7 +196,7 @@ public:
 				if (mask[x + y * w]) {
 					float* k = &kernels[count * KLEN];
 					ScaleLimit* s = &scales[count * CLEN];
-					makeKernel(k, memWork.get(), x, y, w);
+					makeKernel(k, memWork, x, y, w);
 					for (int i = 0; i < CLEN; ++i) {
 						float *slice = &memWork[i * YSize];
 						avgCorr += s[i].scale = std::abs(pCalcCorrelation5x5(k, slice, x, y, w, nullptr));
@@ -199,6 +205,7 @@ public:
 				}
 			}
 		}
+		numPoints = count;
 		avgCorr /= maskpixels * CLEN;
 		// 相関下限（これより小さい相関のピクセルはスケールしない）
 		float limitCorr = avgCorr * corrLowerLimit;
@@ -223,6 +230,23 @@ public:
 		}
 #endif
 
+		// SIMD用に並べ替え
+		kstride = (numPoints + LOGO_KERNEL_ALIGN - 1) / LOGO_KERNEL_ALIGN * LOGO_KERNEL_ALIGN;
+		offsets = std::unique_ptr<int[]>(new int[kstride]());
+		kernelsT = std::unique_ptr<float[]>(new float[KLEN * kstride]());
+		count = 0;
+		for (int y = 2; y < h - 2; ++y) {
+			for (int x = 2; x < w - 2; ++x) {
+				if (mask[x + y * w]) {
+					offsets[count] = x + y * w;
+					for (int t = 0; t < KLEN; ++t) {
+						kernelsT[t * kstride + count] = kernels[count * KLEN + t];
+					}
+					++count;
+				}
+			}
+		}
+
 		// 黒背景の評価値（これがはっきり出たときの基準）
 		float *slice = &memWork[(16 >> CSHIFT) * YSize];
 		blackScore = CorrelationScore(slice, 255);
@@ -239,21 +263,32 @@ public:
 		}
 
 		// ロゴを除去
-		for (int y = 0; y < h; ++y) {
-			for (int x = 0; x < w; ++x) {
-				float srcv = src[x + y * stride];
-				float a = logoAY[x + y * w];
-				float b = logoBY[x + y * w];
-				float bg = a * srcv + b * maxv;
-				float dstv = fade * bg + (1 - fade) * srcv;
-				work[x + y * w] = dstv;
-			}
-		}
+		kernel->RemoveLogo(work, src, stride, logoAY, logoBY, w, h, maxv, fade);
 
 		// 正規化
 		return CorrelationScore(work, maxv) / blackScore;
 	}
 
+	// 複数のフェード値でのEvaluateLogoをまとめて計算（ロゴ除去画像は作らない）
+	// 結果はEvaluateLogoと誤差の範囲で一致する
+	void EvaluateLogoFades(const float *src, float maxv, const float* fades, int numFades, float* result, int stride = -1)
+	{
+		const float *logoAY = GetA(PLANAR_Y);
+		const float *logoBY = GetB(PLANAR_Y);
+
+		if (stride == -1) {
+			stride = w;
+		}
+
+		kernel->LogoScoreFades(result, fades, numFades, src, stride, logoAY, logoBY, maxv, w,
+			offsets.get(), kernelsT.get(), kstride, reinterpret_cast<const float*>(scales.get()), numPoints);
+
+		// 正規化
+		for (int f = 0; f < numFades; ++f) {
+			result[f] /= blackScore;
+		}
+	}
+
 	std::unique_ptr<LogoDataParam> MakeFieldLogo(bool bottom)
 	{
 		auto logo = std::unique_ptr<LogoDataParam>(
@@ -287,34 +322,8 @@ private:
 	// 画素ごとにロゴとの相関を計算
 	float CorrelationScore(const float *work, float maxv)
 	{
-		const uint8_t* mask = GetMask();
-		const float* kernels = GetKernels();
-
-		// ロゴとの相関を評価
-		int count = 0;
-		float result = 0;
-		for (int y = 2; y < h - 2; ++y) {
-			for (int x = 2; x < w - 2; ++x) {
-				if (mask[x + y * w]) {
-					const float* k = &kernels[count * KLEN];
-
-					float avg;
-					float sum = pCalcCorrelation5x5(k, work, x, y, w, &avg);
-					// avg単色の場合の相関値が1になるように正規化
-					ScaleLimit s = scales[count * CLEN + (std::max(0, std::min(255, (int)avg)) >> CSHIFT)];
-					// 1を超える部分は捨てる（ロゴによる相関ではない部分なので）
-					float normalized = std::max(-1.0f, std::min(1.0f, sum * s.scale));
-					// 相関が下限値以下の場合は一部元に戻す
-					float score = normalized * s.scale2;
-
-					result += score;
-
-					++count;
-				}
-			}
-		}
-
-		return result;
+		return kernel->LogoScore(work, w, offsets.get(), kernelsT.get(), kstride,
+			reinterpret_cast<const float*>(scales.get()), numPoints);
 	}
 
 	void AddLogo(float* Y, int maxv)
@@ -433,24 +442,7 @@ class LogoScan
 
 	static void maxfilter(float *data, float *work, int w, int h)
 	{
-		for (int y = 0; y < h; ++y) {
-			work[0 + y * w] = data[0 + y * w];
-			for (int x = 1; x < w - 1; ++x) {
-				float a = data[x - 1 + y * w];
-				float b = data[x + y * w];
-				float c = data[x + 1 + y * w];
-				work[x + y * w] = std::max(a, std::max(b, c));
-			}
-			work[w - 1 + y * w] = data[w - 1 + y * w];
-		}
-		for (int y = 1; y < h - 1; ++y) {
-			for (int x = 0; x < w; ++x) {
-				float a = data[x + (y - 1) * w];
-				float b = data[x + y * w];
-				float c = data[x + (y + 1) * w];
-				work[x + y * w] = std::max(a, std::max(b, c));
-			}
-		}
+		GetLogoKernel().MaxFilter3(data, work, w, h);
 	}
 
 public:
@@ -760,22 +752,29 @@ static void DeintLogo(LogoData& dst, LogoData& src, int w, int h)
 	}
 }
 
-template <typename pixel_t>
-void DeintY(float* dst, const pixel_t* src, int srcPitch, int w, int h)
+// 実装はComputeKernel*.cpp
+inline void DeintY(float* dst, const uint8_t* src, int srcPitch, int w, int h)
+{
+	GetLogoKernel().DeintY8(dst, src, srcPitch, w, h);
+}
+
+inline void DeintY(float* dst, const uint16_t* src, int srcPitch, int w, int h)
 {
-	auto merge = [](int a, int b, int c) { return (a + 2 * b + c + 2) / 4.0f; };
+	GetLogoKernel().DeintY16(dst, src, srcPitch, w, h);
+}
 
-	for (int x = 0; x < w; ++x) {
-		dst[x] = src[x];
-		dst[x + (h - 1) * w] = src[x + (h - 1) * srcPitch];
+// フェード0は元の画素のままなので何もしない
+inline void Delogo(uint8_t* dst, int w, int h, int logopitch, int imgpitch, float maxv, const float* A, const float* B, float fade)
+{
+	if (fade != 0) {
+		GetLogoKernel().Delogo8(dst, w, h, logopitch, imgpitch, maxv, A, B, fade);
 	}
-	for (int y = 1; y < h - 1; ++y) {
-		for (int x = 0; x < w; ++x) {
-			dst[x + y * w] = merge(
-				src[x + (y - 1) * srcPitch],
-				src[x + y * srcPitch],
-				src[x + (y + 1) * srcPitch]);
-		}
+}
+
+inline void Delogo(uint16_t* dst, int w, int h, int logopitch, int imgpitch, float maxv, const float* A, const float* B, float fade)
+{
+	if (fade != 0) {
+		GetLogoKernel().Delogo16(dst, w, h, logopitch, imgpitch, maxv, A, B, fade);
 	}
 }
 
@@ -789,10 +788,239 @@ void CopyY(float* dst, const pixel_t* src, int srcPitch, int w, int h)
 	}
 }
 
+// ロゴ作成用に集めたスキャン範囲のフレーム(YV12)の保存先
+// memoryLimitまではメモリに非圧縮で保持し、超えたらUtVideoで圧縮してファイルに移す
+// 今の所可逆圧縮が8bitのみなので対応は8bitのみ
+class LogoScanFrameStore : AMTObject
+{
+	enum {
+		// メモリに保持するときの確保単位（フレーム数）
+		CHUNK_FRAMES = 256,
+	};
+
+	tstring workfile;
+	int w, h;
+	int numMaxFrames;
+	size_t frameSize;
+	size_t memoryLimit;
+	int numFrames;
+	bool onMemory;
+
+	// メモリ保持
+	std::vector<std::unique_ptr<uint8_t[]>> chunks;
+
+	// ファイル保持
+	CCodecPointer encoder;
+	size_t codedSize;
+	std::unique_ptr<uint8_t[]> memCoded;
+	std::unique_ptr<LosslessVideoFile> file;
+	bool encoding;
+
+	// 読み込み用（スレッドごとにデコーダを持つ）
+	std::unique_ptr<LosslessVideoFile> reader;
+	std::vector<CCodecPointer> decoders;
+	std::vector<std::unique_ptr<uint8_t[]>> codedBatch;
+	std::vector<std::unique_ptr<uint8_t[]>> decodeBuffers;
+
+	uint8_t* MemoryFrame(int i) const {
+		return chunks[i / CHUNK_FRAMES].get() + (i % CHUNK_FRAMES) * frameSize;
+	}
+
+	void WriteCodedFrame(const uint8_t* data) {
+		bool keyFrame = false;
+		size_t codedSize = encoder->EncodeFrame(memCoded.get(), &keyFrame, data);
+		file->writeFrame(memCoded.get(), (int)codedSize);
+	}
+
+	// メモリに保持しているフレームをファイルに移す
+	void Spill() {
+		encoder = make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze"));
+		size_t extraSize = encoder->EncodeGetExtraDataSize();
+		std::vector<uint8_t> extra(extraSize);
+		if (encoder->EncodeGetExtraData(extra.data(), extraSize, UTVF_YV12, w, h)) {
+			THROW(RuntimeException, "failed to EncodeGetExtraData (UtVideo)");
+		}
+		if (encoder->EncodeBegin(UTVF_YV12, w, h, CBGROSSWIDTH_WINDOWS)) {
+			THROW(RuntimeException, "failed to EncodeBegin (UtVideo)");
+		}
+		encoding = true;
+		codedSize = encoder->EncodeGetOutputSize(UTVF_YV12, w, h);
+		memCoded = std::unique_ptr<uint8_t[]>(new uint8_t[codedSize]);
+
+		file = std::unique_ptr<LosslessVideoFile>(new LosslessVideoFile(ctx, workfile, _T("wb")));
+		// フレーム数は最大フレーム数（実際はそこまで書き込まないこともある）
+		file->writeHeader(w, h, numMaxFrames, extra);
+
+		for (int i = 0; i < numFrames; ++i) {
+			WriteCodedFrame(MemoryFrame(i));
+		}
+		chunks.clear();
+		onMemory = false;
+
+		ctx.infoF("ロゴ解析フレームが%.1fMBを超えたのでファイルに保存します",
+			memoryLimit / (1024.0 * 1024.0));
+	}
+
+	CCodec* Decoder(int index) {
+		while ((int)decoders.size() <= index) {
+			auto codec = make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze"));
+			const auto& extra = reader->getExtra();
+			if (codec->DecodeBegin(UTVF_YV12, w, h, CBGROSSWIDTH_WINDOWS, extra.data(), (int)extra.size())) {
+				THROW(RuntimeException, "failed to DecodeBegin (UtVideo)");
+			}
+			decoders.push_back(std::move(codec));
+			decodeBuffers.emplace_back(new uint8_t[frameSize]);
+		}
+		return decoders[index].get();
+	}
+
+	const uint8_t* DecodeFrame(int index, const uint8_t* coded) {
+		uint8_t* dst = decodeBuffers[index].get();
+		if (decoders[index]->DecodeFrame(dst, coded) != frameSize) {
+			THROW(RuntimeException, "failed to DecodeFrame (UtVideo)");
+		}
+		return dst;
+	}
+
+	void OpenReader() {
+		if (reader == nullptr) {
+			reader = std::unique_ptr<LosslessVideoFile>(new LosslessVideoFile(ctx, workfile, _T("rb")));
+			reader->readHeader();
+		}
+	}
+
+	void ReadCodedFrames(int start, int end) {
+		OpenReader();
+		while ((int)codedBatch.size() < end - start) {
+			codedBatch.emplace_back(new uint8_t[codedSize]);
+		}
+		for (int i = start; i < end; ++i) {
+			reader->readFrame(i, codedBatch[i - start].get());
+		}
+	}
+
+public:
+	LogoScanFrameStore(AMTContext& ctx, const tstring& workfile, int w, int h, int numMaxFrames, size_t memoryLimit)
+		: AMTObject(ctx)
+		, workfile(workfile)
+		, w(w)
+		, h(h)
+		, numMaxFrames(numMaxFrames)
+		, frameSize(w * h * 3 / 2)
+		, memoryLimit(memoryLimit)
+		, numFrames(0)
+		, onMemory(true)
+		, encoder(nullptr, DeleteUtVideoCodec)
+		, codedSize(0)
+		, encoding(false)
+	{ }
+
+	~LogoScanFrameStore() {
+		if (encoding) {
+			encoder->EncodeEnd();
+		}
+		for (auto& codec : decoders) {
+			codec->DecodeEnd();
+		}
+	}
+
+	int getNumFrames() const { return numFrames; }
+	size_t getFrameSize() const { return frameSize; }
+	bool isOnMemory() const { return onMemory; }
+
+	// frame: w x hのYV12（Y,U,Vの順に詰めたもの）
+	void addFrame(const uint8_t* frame)
+	{
+		if (numFrames >= numMaxFrames) {
+			THROW(InvalidOperationException, "[LogoScanFrameStore] too many frames");
+		}
+		if (isOnMemory() && (numFrames + 1) * frameSize > memoryLimit) {
+			Spill();
+		}
+		if (isOnMemory()) {
+			if ((numFrames % CHUNK_FRAMES) == 0) {
+				int n = std::min((int)CHUNK_FRAMES, numMaxFrames - numFrames);
+				chunks.emplace_back(new uint8_t[frameSize * n]);
+			}
+			memcpy(MemoryFrame(numFrames), frame, frameSize);
+		}
+		else {
+			WriteCodedFrame(frame);
+		}
+		++numFrames;
+	}
+
+	// 追加終了（以降は読み込みのみ）
+	void finish()
+	{
+		if (encoding) {
+			encoder->EncodeEnd();
+			encoding = false;
+		}
+		// 読み込みは開き直して行う
+		file = nullptr;
+		memCoded = nullptr;
+	}
+
+	// 読み込み用のバッファとデコーダを解放
+	void releaseReadBuffers()
+	{
+		for (auto& codec : decoders) {
+			codec->DecodeEnd();
+		}
+		decoders.clear();
+		decodeBuffers.clear();
+		codedBatch.clear();
+		reader = nullptr;
+	}
+
+	// フレームstart～end-1についてfunc(threadIndex, i, frame)を呼び出す
+	// workersがnullptrのときはこのスレッドで順番に呼び出す（threadIndexは0）
+	// ファイルに移している場合は読み込みだけこのスレッドで行い、デコードは並列に行う
+	void forEachFrame(ParallelWorkers* workers, int start, int end,
+		const std::function<void(int, int, const uint8_t*)>& func)
+	{
+		if (isOnMemory()) {
+			if (workers == nullptr) {
+				for (int i = start; i < end; ++i) {
+					func(0, i, MemoryFrame(i));
+				}
+			}
+			else {
+				workers->run(end - start, [&](int threadIndex, int i) {
+					func(threadIndex, start + i, MemoryFrame(start + i));
+				});
+			}
+			return;
+		}
+		if (workers == nullptr) {
+			// 1フレームずつ読み込んでデコード
+			for (int i = start; i < end; ++i) {
+				ReadCodedFrames(i, i + 1);
+				Decoder(0);
+				func(0, i, DecodeFrame(0, codedBatch[0].get()));
+			}
+		}
+		else {
+			ReadCodedFrames(start, end);
+			// デコーダの生成はこのスレッドで行っておく
+			Decoder(workers->getNumThreads() - 1);
+			workers->run(end - start, [&](int threadIndex, int i) {
+				func(threadIndex, start + i, DecodeFrame(threadIndex, codedBatch[i].get()));
+			});
+		}
+	}
+};
+
 typedef bool(*LOGO_ANALYZE_CB)(float progress, int nread, int total, int ngather);
 
 class LogoAnalyzer : AMTObject
 {
+	enum {
+		// ReMakeLogoで並列に評価するフレーム数（この単位で進捗を通知）
+		BATCH_FRAMES = 256,
+	};
+
 	tstring srcpath;
 	int serviceid;
 
@@ -803,10 +1031,16 @@ class LogoAnalyzer : AMTObject
 	int scanx, scany;
 	int scanw, scanh, thy;
 	int numMaxFrames;
+	// ReMakeLogoの評価スレッド数
+	int numThreads;
+	// 有効フレームをメモリに保持する上限（超えたらworkfileに保存）
+	size_t memoryLimit;
 	int logUVx, logUVy;
 	int imgw, imgh;
 	int numFrames;
 	std::unique_ptr<LogoData> logodata;
+	// 有効フレームの保存先
+	std::unique_ptr<LogoScanFrameStore> frames;
 
 	float progressbase;
 
@@ -814,25 +1048,18 @@ class LogoAnalyzer : AMTObject
 	class InitialLogoCreator : SimpleVideoReader
 	{
 		LogoAnalyzer* pThis;
-		CCodecPointer codec;
 		size_t scanDataSize;
-		size_t codedSize;
 		int readCount;
 		int64_t filesize;
 		std::unique_ptr<uint8_t[]> memScanData;
-		std::unique_ptr<uint8_t[]> memCoded;
-		std::unique_ptr<LosslessVideoFile> file;
 		std::unique_ptr<LogoScan> logoscan;
 	public:
 		InitialLogoCreator(LogoAnalyzer* pThis)
 			: SimpleVideoReader(pThis->ctx)
 			, pThis(pThis)
-			, codec(make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze")))
 			, scanDataSize(pThis->scanw * pThis->scanh * 3 / 2)
-			, codedSize(codec->EncodeGetOutputSize(UTVF_YV12, pThis->scanw, pThis->scanh))
 			, readCount()
 			, memScanData(new uint8_t[scanDataSize])
-			, memCoded(new uint8_t[codedSize])
 		{ }
 		void readAll(const tstring& src, int serviceid)
 		{
@@ -840,7 +1067,7 @@ class LogoAnalyzer : AMTObject
 
 			SimpleVideoReader::readAll(src, serviceid);
 
-			codec->EncodeEnd();
+			pThis->frames->finish();
 
 			logoscan->Normalize(255);
 			pThis->logodata = logoscan->GetLogo(false);
@@ -851,16 +1078,6 @@ class LogoAnalyzer : AMTObject
 	protected:
 		virtual void onFirstFrame(AVStream *videoStream, AVFrame* frame)
 		{
-			size_t extraSize = codec->EncodeGetExtraDataSize();
-			std::vector<uint8_t> extra(extraSize);
-
-			if (codec->EncodeGetExtraData(extra.data(), extraSize, UTVF_YV12, pThis->scanw, pThis->scanh)) {
-				THROW(RuntimeException, "failed to EncodeGetExtraData (UtVideo)");
-			}
-			if (codec->EncodeBegin(UTVF_YV12, pThis->scanw, pThis->scanh, CBGROSSWIDTH_WINDOWS)) {
-				THROW(RuntimeException, "failed to EncodeBegin (UtVideo)");
-			}
-
 			const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)(frame->format));
 
 			pThis->logUVx = desc->log2_chroma_w;
@@ -868,14 +1085,11 @@ class LogoAnalyzer : AMTObject
 			pThis->imgw = frame->width;
 			pThis->imgh = frame->height;
 
-			file = std::unique_ptr<LosslessVideoFile>(
-				new LosslessVideoFile(pThis->ctx, pThis->workfile, _T("wb")));
+			pThis->frames = std::unique_ptr<LogoScanFrameStore>(new LogoScanFrameStore(pThis->ctx,
+				pThis->workfile, pThis->scanw, pThis->scanh, pThis->numMaxFrames, pThis->memoryLimit));
 			logoscan = std::unique_ptr<LogoScan>(
 				new LogoScan(pThis->scanw, pThis->scanh, pThis->logUVx, pThis->logUVy, pThis->thy));
 
-			// フレーム数は最大フレーム数（実際はそこまで書き込まないこともある）
-			file->writeHeader(pThis->scanw, pThis->scanh, pThis->numMaxFrames, extra);
-
 			pThis->numFrames = 0;
 		};
 		virtual bool onFrame(AVFrame* frame)
@@ -898,9 +1112,7 @@ class LogoAnalyzer : AMTObject
 
 				// 有効なフレームは保存しておく
 				CopyYV12(memScanData.get(), scanY, scanU, scanV, pitchY, pitchUV, pThis->scanw, pThis->scanh);
-				bool keyFrame = false;
-				size_t codedSize = codec->EncodeFrame(memCoded.get(), &keyFrame, memScanData.get());
-				file->writeFrame(memCoded.get(), (int)codedSize);
+				pThis->frames->addFrame(memScanData.get());
 			}
 
 			if ((readCount % 200) == 0) {
@@ -923,65 +1135,53 @@ class LogoAnalyzer : AMTObject
 	void ReMakeLogo()
 	{
 		// 複数fade値でロゴを評価 //
-		auto codec = make_unique_ptr(CCodec::CreateInstance(UTVF_ULH0, "Amatsukaze"));
 
 		// ロゴを評価用にインタレ解除
 		LogoDataParam deintLogo(LogoData(scanw, scanh, logUVx, logUVy), scanw, scanh, scanx, scany);
 		DeintLogo(deintLogo, *logodata, scanw, scanh);
 		deintLogo.CreateLogoMask(0.1f);
 
-		size_t scanDataSize = scanw * scanh * 3 / 2;
 		size_t YSize = scanw * scanh;
-		size_t codedSize = codec->EncodeGetOutputSize(UTVF_YV12, scanw, scanh);
-		size_t extraSize = codec->EncodeGetExtraDataSize();
-		auto memScanData = std::unique_ptr<uint8_t[]>(new uint8_t[scanDataSize]);
-		auto memCoded = std::unique_ptr<uint8_t[]>(new uint8_t[codedSize]);
-
-		auto memDeint = std::unique_ptr<float[]>(new float[YSize + 8]);
-		auto memWork = std::unique_ptr<float[]>(new float[YSize + 8]);
 
 		const int numFade = 20;
+		float fades[numFade];
+		for (int fi = 0; fi < numFade; ++fi) {
+			fades[fi] = 0.1f * fi;
+		}
 		auto minFades = std::unique_ptr<int[]>(new int[numFrames]);
-		{
-			LosslessVideoFile file(ctx, workfile, _T("rb"));
-			file.readHeader();
-			auto extra = file.getExtra();
 
-			if (codec->DecodeBegin(UTVF_YV12, scanw, scanh, CBGROSSWIDTH_WINDOWS, extra.data(), (int)extra.size())) {
-				THROW(RuntimeException, "failed to DecodeBegin (UtVideo)");
-			}
+		// 参照するデータより後に破棄されるようにworkersは最後に定義
+		ParallelWorkers workers(numThreads);
 
-			// 全フレームループ
-			for (int i = 0; i < numFrames; ++i) {
-				int64_t codedSize = file.readFrame(i, memCoded.get());
-				if (codec->DecodeFrame(memScanData.get(), memCoded.get()) != scanDataSize) {
-					THROW(RuntimeException, "failed to DecodeFrame (UtVideo)");
-				}
+		// フレームごとの評価は独立なので並列に行う（結果はフレーム番号の位置に書き込むだけ）
+		for (int start = 0; start < numFrames; start += BATCH_FRAMES) {
+			int end = std::min(numFrames, start + BATCH_FRAMES);
+			frames->forEachFrame(&workers, start, end, [&](int threadIndex, int i, const uint8_t* scanData) {
+				ScratchArena::Scope scratch;
+				float* memDeint = scratch.alloc<float>(YSize + 8);
 				// フレームをインタレ解除
-				DeintY(memDeint.get(), memScanData.get(), scanw, scanw, scanh);
-				// fade値ループ
+				DeintY(memDeint, scanData, scanw, scanw, scanh);
+				// 全fade値をまとめて評価
+				float result[numFade];
+				for (int f = 0; f < numFade; f += LOGO_KERNEL_MAX_FADES) {
+					int n = std::min(numFade - f, (int)LOGO_KERNEL_MAX_FADES);
+					deintLogo.EvaluateLogoFades(memDeint, 255.0f, fades + f, n, result + f);
+				}
 				float minResult = FLT_MAX;
 				int minFadeIndex = 0;
 				for (int fi = 0; fi < numFade; ++fi) {
-					float fade = 0.1f * fi;
-					// ロゴを評価
-					float result = std::abs(deintLogo.EvaluateLogo(memDeint.get(), 255.0f, fade, memWork.get()));
-					if (result < minResult) {
-						minResult = result;
+					if (std::abs(result[fi]) < minResult) {
+						minResult = std::abs(result[fi]);
 						minFadeIndex = fi;
 					}
 				}
 				minFades[i] = minFadeIndex;
+			});
 
-				if ((i % 100) == 0) {
-					float progress = (float)i / numFrames * 25 + progressbase;
-					if (cb(progress, i, numFrames, numFrames) == false) {
-						THROW(RuntimeException, "Cancel requested");
-					}
-				}
+			float progress = (float)end / numFrames * 25 + progressbase;
+			if (cb(progress, end, numFrames, numFrames) == false) {
+				THROW(RuntimeException, "Cancel requested");
 			}
-
-			codec->DecodeEnd();
 		}
 
 		// 評価値を集約
@@ -993,38 +1193,25 @@ class LogoAnalyzer : AMTObject
 		int maxi = (int)(std::max_element(numMinFades.begin(), numMinFades.end()) - numMinFades.begin());
 		printf("maxi = %d (%.1f%%)\n", maxi, numMinFades[maxi] / (float)numFrames * 100.0f);
 
-		LogoScan logoscan(scanw, scanh, logUVx, logUVy, thy);
-		{
-			LosslessVideoFile file(ctx, workfile, _T("rb"));
-			file.readHeader();
-			auto extra = file.getExtra();
-
-			if (codec->DecodeBegin(UTVF_YV12, scanw, scanh, CBGROSSWIDTH_WINDOWS, extra.data(), (int)extra.size())) {
-				THROW(RuntimeException, "failed to DecodeBegin (UtVideo)");
-			}
-
-			int scanUVw = scanw >> logUVx;
-			int scanUVh = scanh >> logUVy;
-			int offU = scanw * scanh;
-			int offV = offU + scanUVw * scanUVh;
+		// 並列評価用に読み込んだバッファは次のパスでは不要
+		frames->releaseReadBuffers();
 
-			// 全フレームループ
-			for (int i = 0; i < numFrames; ++i) {
-				int64_t codedSize = file.readFrame(i, memCoded.get());
-				if (codec->DecodeFrame(memScanData.get(), memCoded.get()) != scanDataSize) {
-					THROW(RuntimeException, "failed to DecodeFrame (UtVideo)");
-				}
-				// ロゴのあるフレームだけAddFrame
-				if (minFades[i] > 8) { // TODO: 調整
-					const uint8_t* ptr = memScanData.get();
-					logoscan.AddFrame(ptr, ptr + offU, ptr + offV, scanw, scanUVw);
-				}
+		LogoScan logoscan(scanw, scanh, logUVx, logUVy, thy);
 
-				if ((i % 2000) == 0) printf("%d frames\n", i);
+		int scanUVw = scanw >> logUVx;
+		int scanUVh = scanh >> logUVy;
+		int offU = scanw * scanh;
+		int offV = offU + scanUVw * scanUVh;
+
+		// LogoScanへの追加は結果が順番に依存するのでこのスレッドで順番に行う
+		frames->forEachFrame(nullptr, 0, numFrames, [&](int threadIndex, int i, const uint8_t* ptr) {
+			// ロゴのあるフレームだけAddFrame
+			if (minFades[i] > 8) { // TODO: 調整
+				logoscan.AddFrame(ptr, ptr + offU, ptr + offV, scanw, scanUVw);
 			}
 
-			codec->DecodeEnd();
-		}
+			if ((i % 2000) == 0) printf("%d frames\n", i);
+		});
 
 		// ロゴ作成
 		logoscan.Normalize(255);
@@ -1050,6 +1237,8 @@ public:
 		, scanh(h)
 		, thy(thy)
 		, numMaxFrames(numMaxFrames)
+		, numThreads(GetProcessorCount())
+		, memoryLimit((size_t)1024 * 1024 * 1024)
 		, cb(cb)
 	{
 		//
@@ -1069,6 +1258,9 @@ public:
 		ReMakeLogo();
 		//ReMakeLogo();
 
+		// 有効フレームはもう使わない
+		frames = nullptr;
+
 		if (cb(1, numFrames, numFrames, numFrames) == false) {
 			THROW(RuntimeException, "Cancel requested");
 		}
@@ -1102,6 +1294,94 @@ struct LogoAnalyzeFrame
 	float p[11], t[11], b[11];
 };
 
+// LogoAnalyzeFrameのフェード値（f / 10）
+static const float* LogoAnalyzeFades() {
+	static const float fades[11] = {
+		0.0f / 10.0f, 1.0f / 10.0f, 2.0f / 10.0f, 3.0f / 10.0f, 4.0f / 10.0f, 5.0f / 10.0f,
+		6.0f / 10.0f, 7.0f / 10.0f, 8.0f / 10.0f, 9.0f / 10.0f, 10.0f / 10.0f
+	};
+	return fades;
+}
+
+// 1フレーム分のLogoAnalyzeFrameを計算
+// deint: インタレ解除したフレーム, copy: 元フレーム（幅w）
+static void AnalyzeLogoFrame(LogoAnalyzeFrame& info, LogoDataParam& deintLogo,
+	LogoDataParam& fieldLogoT, LogoDataParam& fieldLogoB, const float* deint, const float* copy, int w, float maxv)
+{
+	const float* fades = LogoAnalyzeFades();
+	// フェード値ごとではなくロゴごとに1回の走査で全フェード値を評価する
+	deintLogo.EvaluateLogoFades(deint, maxv, fades, 11, info.p);
+	fieldLogoT.EvaluateLogoFades(copy, maxv, fades, 11, info.t, w * 2);
+	fieldLogoB.EvaluateLogoFades(copy + w, maxv, fades, 11, info.b, w * 2);
+	for (int f = 0; f <= 10; ++f) {
+		info.p[f] = std::abs(info.p[f]);
+		info.t[f] = std::abs(info.t[f]);
+		info.b[f] = std::abs(info.b[f]);
+	}
+}
+
+// AMTEraseLogoがフェード値を決めるのに使うフレームごとの解析結果
+// LogoAnalyzeFrameのp,t,bそれぞれで評価値が最小になるフェードのインデックス(0～10)
+struct LogoFadeFrame
+{
+	uint8_t p, t, b;
+};
+
+static LogoFadeFrame MinFades(const LogoAnalyzeFrame& info)
+{
+	LogoFadeFrame fade;
+	fade.p = (uint8_t)(std::min_element(info.p, info.p + 11) - info.p);
+	fade.t = (uint8_t)(std::min_element(info.t, info.t + 11) - info.t);
+	fade.b = (uint8_t)(std::min_element(info.b, info.b + 11) - info.b);
+	return fade;
+}
+
+// CM解析で計算したLogoFadeFrameを保存するファイル
+// エンコード時にAMTAnalyzeLogoで全フレームを解析し直さなくて済むようにする
+class LogoFadeFile
+{
+public:
+	enum {
+		MAGIC = 0x4E41474C, // "LGAN"
+		VERSION = 1
+	};
+
+	static void save(const tstring& path, const std::vector<LogoFadeFrame>& frames)
+	{
+		File file(path, _T("wb"));
+		file.writeValue<int32_t>(MAGIC);
+		file.writeValue<int32_t>(VERSION);
+		file.writeArray(frames);
+	}
+
+	// 読めなかったり、フレーム数が合わなかったらfalse
+	static bool load(const tstring& path, int numFrames, std::vector<LogoFadeFrame>& frames)
+	{
+		try {
+			File file(path, _T("rb"));
+			if (file.readValue<int32_t>() != MAGIC ||
+				file.readValue<int32_t>() != VERSION)
+			{
+				return false;
+			}
+			std::vector<LogoFadeFrame> loaded = file.readArray<LogoFadeFrame>();
+			if ((int)loaded.size() != numFrames) {
+				return false;
+			}
+			for (const auto& f : loaded) {
+				if (f.p > 10 || f.t > 10 || f.b > 10) {
+					return false;
+				}
+			}
+			frames.swap(loaded);
+			return true;
+		}
+		catch (const Exception&) {
+			return false;
+		}
+	}
+};
+
 // ロゴ除去用解析フィルタ
 class AMTAnalyzeLogo : public GenericVideoFilter
 {
@@ -1120,9 +1400,9 @@ class AMTAnalyzeLogo : public GenericVideoFilter
 	PVideoFrame GetFrameT(int n, IScriptEnvironment2* env)
 	{
 		size_t YSize = header.w * header.h;
-		auto memCopy = std::unique_ptr<float[]>(new float[YSize + 8]);
-		auto memDeint = std::unique_ptr<float[]>(new float[YSize + 8]);
-		auto memWork = std::unique_ptr<float[]>(new float[YSize + 8]);
+		ScratchArena::Scope scratch;
+		float* memCopy = scratch.alloc<float>(YSize + 8);
+		float* memDeint = scratch.alloc<float>(YSize + 8);
 
 		PVideoFrame dst = env->NewVideoFrame(vi);
 		LogoAnalyzeFrame* pDst = reinterpret_cast<LogoAnalyzeFrame*>(dst->GetWritePtr());
@@ -1142,17 +1422,13 @@ class AMTAnalyzeLogo : public GenericVideoFilter
 			int off = header.imgx + header.imgy * pitchY;
 			int offUV = (header.imgx >> header.logUVx) + (header.imgy >> header.logUVy) * pitchUV;
 
-			CopyY(memCopy.get(), srcY + off, pitchY, header.w, header.h);
+			CopyY(memCopy, srcY + off, pitchY, header.w, header.h);
 
 			// フレームをインタレ解除
-			DeintY(memDeint.get(), srcY + off, pitchY, header.w, header.h);
+			DeintY(memDeint, srcY + off, pitchY, header.w, header.h);
 
 			LogoAnalyzeFrame info;
-			for (int f = 0; f <= 10; ++f) {
-				info.p[f] = std::abs(deintLogo->EvaluateLogo(memDeint.get(), maxv, (float)f / 10.0f, memWork.get()));
-				info.t[f] = std::abs(fieldLogoT->EvaluateLogo(memCopy.get(), maxv, (float)f / 10.0f, memWork.get(), header.w * 2));
-				info.b[f] = std::abs(fieldLogoB->EvaluateLogo(memCopy.get() + header.w, maxv, (float)f / 10.0f, memWork.get(), header.w * 2));
-			}
+			AnalyzeLogoFrame(info, *deintLogo, *fieldLogoT, *fieldLogoB, memDeint, memCopy, header.w, maxv);
 
 			pDst[i] = info;
 		}
@@ -1240,32 +1516,19 @@ class AMTEraseLogo : public GenericVideoFilter
 	PClip analyzeclip;
 
 	std::vector<int> frameResult;
+	// CM解析で保存した解析結果（ある場合はanalyzeclipは使わない）
+	std::vector<LogoFadeFrame> fadeFrames;
 	std::unique_ptr<LogoDataParam> logo;
 	LogoHeader header;
 	int mode;
 	int maxFadeLength;
 
-	template <typename pixel_t>
-	void Delogo(pixel_t* dst, int w, int h, int logopitch, int imgpitch, float maxv, const float* A, const float* B, float fade)
-	{
-		for (int y = 0; y < h; ++y) {
-			for (int x = 0; x < w; ++x) {
-				float srcv = dst[x + y * imgpitch];
-				float a = A[x + y * logopitch];
-				float b = B[x + y * logopitch];
-				float bg = a * srcv + b * maxv;
-				float tmp = fade * bg + (1 - fade) * srcv;
-				dst[x + y * imgpitch] = (pixel_t)std::min(std::max(tmp + 0.5f, 0.0f), maxv);
-			}
-		}
-	}
-
 	void CalcFade2(int n, float& fadeT, float& fadeB, IScriptEnvironment2* env)
 	{
 		enum {
 			DIST = 4,
 		};
-		LogoAnalyzeFrame frames[DIST * 2 + 1];
+		LogoFadeFrame frames[DIST * 2 + 1];
 
 		int prev_n = INT_MAX;
 		PVideoFrame frame;
@@ -1274,6 +1537,13 @@ class AMTEraseLogo : public GenericVideoFilter
 			int analyze_n = (nsrc + i) >> 3;
 			int idx = (nsrc + i) & 7;
 
+			if (fadeFrames.size() > 0) {
+				// AMTAnalyzeLogoがanalyze_nのidx番目に解析するフレーム（範囲外は端のフレーム）
+				int nfade = std::max(0, std::min(vi.num_frames - 1, analyze_n * 8 + idx));
+				frames[i + DIST] = fadeFrames[nfade];
+				continue;
+			}
+
 			if (analyze_n != prev_n) {
 				frame = analyzeclip->GetFrame(analyze_n, env);
 				prev_n = analyze_n;
@@ -1281,16 +1551,16 @@ class AMTEraseLogo : public GenericVideoFilter
 
 			const LogoAnalyzeFrame* pInfo =
 				reinterpret_cast<const LogoAnalyzeFrame*>(frame->GetReadPtr());
-			frames[i + DIST] = pInfo[idx];
+			frames[i + DIST] = MinFades(pInfo[idx]);
 		}
 		frame = nullptr;
 
 		int minfades[DIST * 2 + 1];
 		for (int i = 0; i < DIST * 2 + 1; ++i) {
-			minfades[i] = (int)(std::min_element(frames[i].p, frames[i].p + 11) - frames[i].p);
+			minfades[i] = frames[i].p;
 		}
-		int minT = (int)(std::min_element(frames[DIST].t, frames[DIST].t + 11) - frames[DIST].t);
-		int minB = (int)(std::min_element(frames[DIST].b, frames[DIST].b + 11) - frames[DIST].b);
+		int minT = frames[DIST].t;
+		int minB = frames[DIST].b;
 		// 前後4フレームを見てフェードしてるか突然消えてるか判断
 		float before_fades = 0;
 		float after_fades = 0;
@@ -1324,12 +1594,14 @@ class AMTEraseLogo : public GenericVideoFilter
 			// ロゴ解析結果を大局的に使って、
 			// 切り替わり周辺だけリアルタイム解析結果を使う
 			int halfWidth = (maxFadeLength >> 1);
-			std::vector<int> frames(halfWidth * 2 + 1);
+			int numFrames = halfWidth * 2 + 1;
+			ScratchArena::Scope scratch;
+			int* frames = scratch.alloc<int>(numFrames);
 			for (int i = -halfWidth; i <= halfWidth; ++i) {
 				int nsrc = std::max(0, std::min(vi.num_frames - 1, n + i));
 				frames[i + halfWidth] = frameResult[nsrc];
 			}
-			if (std::all_of(frames.begin(), frames.end(), [&](int p) { return p == frames[0]; })) {
+			if (std::all_of(frames, frames + numFrames, [&](int p) { return p == frames[0]; })) {
 				// ON or OFF
 				fadeT = fadeB = ((frames[halfWidth] == 2) ? 1.0f : 0.0f);
 			}
@@ -1344,6 +1616,15 @@ class AMTEraseLogo : public GenericVideoFilter
 	PVideoFrame GetFrameT(int n, IScriptEnvironment2* env)
 	{
 		PVideoFrame frame = child->GetFrame(n, env);
+
+		float fadeT, fadeB;
+		CalcFade(n, fadeT, fadeB, env);
+
+		if (mode == 0 && fadeT == 0 && fadeB == 0) {
+			// ロゴなし（ロゴ除去しても元のまま）
+			return frame;
+		}
+
 		env->MakeWritable(&frame);
 
 		float maxv = (float)((1 << vi.BitsPerComponent()) - 1);
@@ -1357,10 +1638,7 @@ class AMTEraseLogo : public GenericVideoFilter
 		int offUV = (header.imgx >> header.logUVx) + (header.imgy >> header.logUVy) * pitchUV;
 
 		if (mode == 0) { // 通常
-			float fadeT, fadeB;
-			CalcFade(n, fadeT, fadeB, env);
-
-			// 最適Fade値でロゴ除去
+			// 最適Fade値でロゴ除去（フェード0のフィールドはDelogoで飛ばす）
 			const float *logoAY = logo->GetA(PLANAR_Y);
 			const float *logoBY = logo->GetB(PLANAR_Y);
 			const float *logoAU = logo->GetA(PLANAR_U);
@@ -1400,9 +1678,6 @@ class AMTEraseLogo : public GenericVideoFilter
 		}
 
 		// ロゴフレームデバッグ用
-		float fadeT, fadeB;
-		CalcFade(n, fadeT, fadeB, env);
-
 		const char* str = "X";
 		if (fadeT == fadeB) {
 			str = (fadeT < 0.5) ? "X" : "O";
@@ -1461,7 +1736,8 @@ class AMTEraseLogo : public GenericVideoFilter
 	}
 
 public:
-	AMTEraseLogo(PClip clip, PClip analyzeclip, const tstring& logoPath, const tstring& logofPath, int mode, int maxFadeLength, IScriptEnvironment* env)
+	AMTEraseLogo(PClip clip, PClip analyzeclip, const tstring& logoPath, const tstring& logofPath,
+		const tstring& analysisPath, int mode, int maxFadeLength, IScriptEnvironment* env)
 		: GenericVideoFilter(clip)
 		, analyzeclip(analyzeclip)
 		, mode(mode)
@@ -1478,6 +1754,12 @@ public:
 		if (logofPath.size() > 0) {
 			ReadLogoFrameFile(logofPath, env);
 		}
+
+		if (analysisPath.size() > 0) {
+			if (!LogoFadeFile::load(analysisPath, vi.num_frames, fadeFrames)) {
+				env->ThrowError("Failed to read logo analysis file (%s)", analysisPath.c_str());
+			}
+		}
 	}
 
 	PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env_)
@@ -1511,6 +1793,7 @@ public:
 			args[1].AsClip(),       // analyzeclip
 			to_tstring(args[2].AsString()),			// logopath
 			to_tstring(args[3].AsString("")),		// logofpath
+			to_tstring(args[6].AsString("")),		// analysis
 			args[4].AsInt(0),       // mode
 			args[5].AsInt(16),      // maxfade
 			env
@@ -1518,21 +1801,102 @@ public:
 	}
 };
 
+struct LogoFrameResult {
+	int result; // 0:ロゴなし 1:不明 2:ロゴあり
+	float score;
+};
+
+// LogoFrame::writeResultのフィルタ
+// rawScoresは前後にmax(halfAvgFrames, halfMedianFrames)フレーム分参照できること
+// 窓の最大値は単調キュー、移動平均は累積和、メディアンはソート済み窓の入れ替えで求めるので
+// フレーム数に対して線形時間（結果は窓ごとに計算した場合と同じ）
+static void SmoothLogoScores(const float* rawScores, int numFrames,
+	int halfAvgFrames, int halfMedianFrames, float threshL, float thresh, LogoFrameResult* frameResult)
+{
+	int aveFrames = halfAvgFrames * 2 + 1;
+	int medianFrames = halfMedianFrames * 2 + 1;
+
+	// winMax[j] = rawScores[j - halfAvgFrames, j)の最大値 (j = 0～numFrames + halfAvgFrames)
+	// フレームiの前の最大値はwinMax[i]、後ろの最大値はwinMax[i + 1 + halfAvgFrames]
+	std::vector<float> winMax(numFrames + halfAvgFrames + 1);
+	{
+		std::vector<int> queue(numFrames + halfAvgFrames * 2);
+		int qhead = 0, qtail = 0;
+		for (int k = -halfAvgFrames; k < numFrames + halfAvgFrames; ++k) {
+			// 同じ値は前のものを残す（std::max_elementと同じ）
+			while (qtail > qhead && rawScores[queue[qtail - 1]] < rawScores[k]) --qtail;
+			queue[qtail++] = k;
+			while (queue[qhead] <= k - halfAvgFrames) ++qhead;
+			if (k + 1 >= 0) {
+				winMax[k + 1] = rawScores[queue[qhead]];
+			}
+		}
+	}
+
+	// 移動平均の累積和はdoubleで持つ
+	// 元はfloatで窓ごとに足していたので、閾値付近だけは同じ方法で計算して判定を一致させる
+	const double AVG_EPS = 1e-3;
+	double avgSum = 0;
+	for (int k = -halfAvgFrames; k <= halfAvgFrames; ++k) {
+		avgSum += rawScores[k];
+	}
+
+	// メディアン用のソート済み窓
+	std::vector<float> medianBuf(rawScores - halfMedianFrames, rawScores + halfMedianFrames + 1);
+	std::sort(medianBuf.begin(), medianBuf.end());
+
+	for (int i = 0; i < numFrames; ++i) {
+		// MinMax
+		// 前の最大値と後ろの最大値の小さい方を取る
+		// 動きの多い映像でロゴがかき消されることがあるので、それを救済する
+		float beforeMax = winMax[i];
+		float afterMax = winMax[i + 1 + halfAvgFrames];
+		float minMax = std::min(beforeMax, afterMax);
+		int minMaxResult = (std::abs(minMax) < threshL) ? 1 : (minMax < 0.0f) ? 0 : 2;
+
+		// 移動平均
+		// MinMaxだけだと薄くても安定して表示されてるとかが識別できないので
+		// これも必要
+		double davg = avgSum / aveFrames;
+		float avg = (std::abs(std::abs(davg) - thresh) < AVG_EPS)
+			? std::accumulate(rawScores + i - halfAvgFrames, rawScores + i + halfAvgFrames + 1, 0.0f) / aveFrames
+			: (float)davg;
+		int avgResult = (std::abs(avg) < thresh) ? 1 : (avg < 0.0f) ? 0 : 2;
+		avgSum += (double)rawScores[i + halfAvgFrames + 1] - rawScores[i - halfAvgFrames];
+
+		// 両者が違ってたら不明とする
+		frameResult[i].result = (minMaxResult != avgResult) ? 1 : minMaxResult;
+
+		// 生の値は動きが激しいので少しメディアンフィルタをかけておく
+		frameResult[i].score = medianBuf[halfMedianFrames];
+		if (i + 1 < numFrames) {
+			medianBuf.erase(std::lower_bound(medianBuf.begin(), medianBuf.end(), rawScores[i - halfMedianFrames]));
+			float next = rawScores[i + halfMedianFrames + 1];
+			medianBuf.insert(std::upper_bound(medianBuf.begin(), medianBuf.end(), next), next);
+		}
+	}
+}
+
 class LogoFrame : AMTObject
 {
 	int numLogos;
 	std::unique_ptr<LogoDataParam[]> logoArr;
 	std::unique_ptr<LogoDataParam[]> deintArr;
+	// AMTEraseLogo用の解析（enableFadeAnalysis()したときだけ）
+	std::unique_ptr<std::unique_ptr<LogoDataParam>[]> fieldTArr;
+	std::unique_ptr<std::unique_ptr<LogoDataParam>[]> fieldBArr;
 
 	int maxYSize;
 	int numFrames;
 	int framesPerSec;
+	int numThreads;
 	VideoInfo vi;
 
 	struct EvalResult {
 		float corr0, corr1;
 	};
 	std::unique_ptr<EvalResult[]> evalResults;
+	std::unique_ptr<LogoFadeFrame[]> fadeResults;
 
 	// 絶対値<0.2fは不明とみなす
 	const float THRESH = 0.2f;
@@ -1541,10 +1905,16 @@ class LogoFrame : AMTObject
 	float logoRatio;
 
 	template <typename pixel_t>
-	void ScanFrame(PVideoFrame& frame, float* memDeint, float* memWork, float maxv, EvalResult* outResult)
+	void ScanFrame(PVideoFrame& frame, float maxv, EvalResult* outResult, LogoFadeFrame* outFade)
 	{
+		// 作業領域は評価するスレッドのものを使う
+		ScratchArena::Scope scratch;
+		float* memDeint = scratch.alloc<float>(maxYSize + 8);
+		float* memWork = scratch.alloc<float>(maxYSize + 8);
+		float* memCopy = (outFade != nullptr) ? scratch.alloc<float>(maxYSize + 8) : nullptr;
+
 		const pixel_t* srcY = reinterpret_cast<const pixel_t*>(frame->GetReadPtr(PLANAR_Y));
-		int pitchY = frame->GetPitch(PLANAR_Y);
+		int pitchY = frame->GetPitch(PLANAR_Y) / sizeof(pixel_t);
 
 		for (int i = 0; i < numLogos; ++i) {
 			LogoDataParam& logo = deintArr[i];
@@ -1554,6 +1924,9 @@ class LogoFrame : AMTObject
 			{
 				outResult[i].corr0 = 0;
 				outResult[i].corr1 = -1;
+				if (outFade != nullptr) {
+					outFade[i] = LogoFadeFrame();
+				}
 				continue;
 			}
 
@@ -1564,19 +1937,36 @@ class LogoFrame : AMTObject
 			// ロゴ評価
 			outResult[i].corr0 = logo.EvaluateLogo(memDeint, maxv, 0, memWork);
 			outResult[i].corr1 = logo.EvaluateLogo(memDeint, maxv, 1, memWork);
+
+			if (outFade != nullptr) {
+				// AMTAnalyzeLogoと同じ解析
+				CopyY(memCopy, srcY + off, pitchY, logo.getWidth(), logo.getHeight());
+				LogoAnalyzeFrame info;
+				AnalyzeLogoFrame(info, logo, *fieldTArr[i], *fieldBArr[i], memDeint, memCopy, logo.getWidth(), maxv);
+				outFade[i] = MinFades(info);
+			}
+		}
+	}
+
+	LogoFadeFrame* FadeResultPtr(int n) {
+		return fieldTArr ? &fadeResults[n * numLogos] : nullptr;
+	}
+
+	void AllocResults() {
+		evalResults = std::unique_ptr<EvalResult[]>(new EvalResult[vi.num_frames * numLogos]);
+		if (fieldTArr) {
+			fadeResults = std::unique_ptr<LogoFadeFrame[]>(new LogoFadeFrame[vi.num_frames * numLogos]);
 		}
 	}
 
 	template <typename pixel_t>
 	void IterateFrames(PClip clip, IScriptEnvironment2* env)
 	{
-		auto memDeint = std::unique_ptr<float[]>(new float[maxYSize + 8]);
-		auto memWork = std::unique_ptr<float[]>(new float[maxYSize + 8]);
 		float maxv = (float)((1 << vi.BitsPerComponent()) - 1);
-		evalResults = std::unique_ptr<EvalResult[]>(new EvalResult[vi.num_frames * numLogos]);
+		AllocResults();
 		for (int n = 0; n < vi.num_frames; ++n) {
 			PVideoFrame frame = clip->GetFrame(n, env);
-			ScanFrame<pixel_t>(frame, memDeint.get(), memWork.get(), maxv, &evalResults[n * numLogos]);
+			ScanFrame<pixel_t>(frame, maxv, &evalResults[n * numLogos], FadeResultPtr(n));
 
 			if ((n % 5000) == 0) {
 				ctx.infoF("%6d/%d", n, vi.num_frames);
@@ -1588,9 +1978,70 @@ class LogoFrame : AMTObject
 		ctx.info("Finished");
 	}
 
+	// フレームの取得はこのスレッドで順番に行い、ロゴ評価はワーカースレッドで行う
+	// 評価中に次のバッチのフレームを取得しておく
+	// 結果はフレーム番号の位置に書き込むだけなのでシングルスレッドと同じになる
+	template <typename pixel_t>
+	void IterateFramesParallel(PClip clip, IScriptEnvironment2* env)
+	{
+		int batchSize = numThreads * 8;
+		float maxv = (float)((1 << vi.BitsPerComponent()) - 1);
+		AllocResults();
+
+		std::vector<PVideoFrame> batch[2];
+		int batchStart[2] = { 0 };
+		auto fetch = [&](std::vector<PVideoFrame>& frames, int start) {
+			frames.clear();
+			for (int n = start; n < std::min(start + batchSize, vi.num_frames); ++n) {
+				frames.push_back(clip->GetFrame(n, env));
+				if ((n % 5000) == 0) {
+					ctx.infoF("%6d/%d", n, vi.num_frames);
+				}
+			}
+		};
+
+		// 参照するデータより後に破棄されるようにworkersは最後に定義
+		ParallelWorkers workers(numThreads);
+		fetch(batch[0], 0);
+		for (int cur = 0; batch[cur].size() > 0; cur ^= 1) {
+			std::vector<PVideoFrame>& frames = batch[cur];
+			int start = batchStart[cur];
+			workers.post((int)frames.size(), [&, start](int threadIndex, int i) {
+				ScanFrame<pixel_t>(frames[i], maxv, &evalResults[(start + i) * numLogos], FadeResultPtr(start + i));
+			});
+			batchStart[cur ^ 1] = start + (int)frames.size();
+			try {
+				fetch(batch[cur ^ 1], batchStart[cur ^ 1]);
+			}
+			catch (...) {
+				workers.wait();
+				throw;
+			}
+			workers.wait();
+			frames.clear();
+		}
+		numFrames = vi.num_frames;
+		framesPerSec = (int)std::round((float)vi.fps_numerator / vi.fps_denominator);
+
+		ctx.info("Finished");
+	}
+
+	template <typename pixel_t>
+	void ScanFramesT(PClip clip, IScriptEnvironment2* env)
+	{
+		if (numThreads > 0) {
+			IterateFramesParallel<pixel_t>(clip, env);
+		}
+		else {
+			IterateFrames<pixel_t>(clip, env);
+		}
+	}
+
 public:
-	LogoFrame(AMTContext& ctx, const std::vector<tstring>& logofiles, float maskratio)
+	// numThreads: ロゴ評価を並列に行うスレッド数（0ならフレーム取得と同じスレッドで評価）
+	LogoFrame(AMTContext& ctx, const std::vector<tstring>& logofiles, float maskratio, int numThreads = 0)
 		: AMTObject(ctx)
+		, numThreads(numThreads)
 		, bestLogo(-1)
 	{
 		numLogos = (int)logofiles.size();
@@ -1615,15 +2066,31 @@ public:
 		}
 	}
 
+	// scanFramesでAMTEraseLogo用の解析(AMTAnalyzeLogo)も一緒に行う
+	// 結果はwriteFadeAnalysisで出力できる
+	void enableFadeAnalysis(float maskratio)
+	{
+		fieldTArr = std::unique_ptr<std::unique_ptr<LogoDataParam>[]>(new std::unique_ptr<LogoDataParam>[numLogos]);
+		fieldBArr = std::unique_ptr<std::unique_ptr<LogoDataParam>[]>(new std::unique_ptr<LogoDataParam>[numLogos]);
+		for (int i = 0; i < numLogos; ++i) {
+			if (logoArr[i].isValid()) {
+				fieldTArr[i] = logoArr[i].MakeFieldLogo(false);
+				fieldTArr[i]->CreateLogoMask(maskratio);
+				fieldBArr[i] = logoArr[i].MakeFieldLogo(true);
+				fieldBArr[i]->CreateLogoMask(maskratio);
+			}
+		}
+	}
+
 	void scanFrames(PClip clip, IScriptEnvironment2* env)
 	{
 		vi = clip->GetVideoInfo();
 		int pixelSize = vi.ComponentSize();
 		switch (pixelSize) {
 		case 1:
-			return IterateFrames<uint8_t>(clip, env);
+			return ScanFramesT<uint8_t>(clip, env);
 		case 2:
-			return IterateFrames<uint16_t>(clip, env);
+			return ScanFramesT<uint16_t>(clip, env);
 		default:
 			env->ThrowError("[LogoFrame] Unsupported pixel format");
 		}
@@ -1681,6 +2148,26 @@ public:
 		logoRatio = (float)logoSummary[bestLogo].numFrames / numFrames;
 	}
 
+	// logoIndexに指定したロゴのAMTEraseLogo用解析ファイルを出力
+	// logoIndexの指定がない場合(-1)は、bestLogoを出力
+	void writeFadeAnalysis(const tstring& outpath, int logoIndex = -1)
+	{
+		if (!fadeResults) {
+			THROW(InvalidOperationException, "enableFadeAnalysis() is not called");
+		}
+		if (logoIndex < 0) {
+			if (bestLogo < 0) {
+				selectLogo();
+			}
+			logoIndex = bestLogo;
+		}
+		std::vector<LogoFadeFrame> frames(numFrames);
+		for (int n = 0; n < numFrames; ++n) {
+			frames[n] = fadeResults[n * numLogos + logoIndex];
+		}
+		LogoFadeFile::save(outpath, frames);
+	}
+
 	// logoIndexに指定したロゴのlogoframeファイルを出力
 	// logoIndexの指定がない場合(-1)は、bestLogoを出力
 	void writeResult(const tstring& outpath, int logoIndex = -1)
@@ -1715,39 +2202,12 @@ public:
 		std::fill(rawScores_.begin(), rawScores, rawScores[0]);
 		std::fill(rawScores + numFrames, rawScores_.end(), rawScores[numFrames - 1]);
 
-		struct FrameResult {
-			int result;
-			float score;
-		};
+		typedef LogoFrameResult FrameResult;
 
 		// フィルタで均す
 		std::vector<FrameResult> frameResult(numFrames);
-		std::vector<float> medianBuf(medianFrames);
-		for (int i = 0; i < numFrames; ++i) {
-			// MinMax
-			// 前の最大値と後ろの最大値の小さい方を取る
-			// 動きの多い映像でロゴがかき消されることがあるので、それを救済する
-			float beforeMax = *std::max_element(rawScores + i - halfAvgFrames, rawScores + i);
-			float afterMax = *std::max_element(rawScores + i + 1, rawScores + i + 1 + halfAvgFrames);
-			float minMax = std::min(beforeMax, afterMax);
-			int minMaxResult = (std::abs(minMax) < threshL) ? 1 : (minMax < 0.0f) ? 0 : 2;
-
-			// 移動平均
-			// MinMaxだけだと薄くても安定して表示されてるとかが識別できないので
-			// これも必要
-			float avg = std::accumulate(rawScores + i - halfAvgFrames,
-				rawScores + i + halfAvgFrames + 1, 0.0f) / aveFrames;
-			int avgResult = (std::abs(avg) < THRESH) ? 1 : (avg < 0.0f) ? 0 : 2;
-
-			// 両者が違ってたら不明とする
-			frameResult[i].result = (minMaxResult != avgResult) ? 1 : minMaxResult;
-
-			// 生の値は動きが激しいので少しメディアンフィルタをかけておく
-			std::copy(rawScores + i - halfMedianFrames,
-				rawScores + i + halfMedianFrames + 1, medianBuf.begin());
-			std::sort(medianBuf.begin(), medianBuf.end());
-			frameResult[i].score = medianBuf[halfMedianFrames];
-		}
+		SmoothLogoScores(&rawScores[0], numFrames, halfAvgFrames, halfMedianFrames,
+			threshL, THRESH, frameResult.data());
 
 		// 不明部分を推測
 		// 両側がロゴありとなっていたらロゴありとする
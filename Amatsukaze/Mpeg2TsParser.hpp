@@ -270,48 +270,68 @@ private:
 /** @brief TSpPbg؂o
 * inputTS()Kv񐔌ĂяočŌflush()KĂяoƁB
 * flush()ĂяoȂƓ̃obt@Ɏcf[^ȂB
+* o͂TsPacket͉\Ȍ̓f[^𒼐ڎwiRs[Ȃĵ
+* onTsPacket()̊OTsPacket̃f[^QƂĂ͂ȂȂB
+* obt@Ɏ͓̂͂̋E܂B
+* pPbg188/192(M2TS)/204oCg͎ʂB
+* ǂ̏ꍇTsPacket͓oCgn܂188oCgwB
 */
 class TsPacketParser : public AMTObject {
 	enum {
 		// R[hTƂɃ`FbNpPbg
 		CHECK_PACKET_NUM = 8,
+		// o͔ɕKvȍő̐ǂ݃oCgiŒ̃pPbgŌ܂j
+		LOOKAHEAD_BYTES = CHECK_PACKET_NUM * TS_PACKET_LENGTH3,
 	};
 public:
 	TsPacketParser(AMTContext& ctx)
 		: AMTObject(ctx)
 		, syncOK(false)
+		, resetCalled(false)
+		, packetStride(TS_PACKET_LENGTH)
 	{ }
 
 	/** @brief TSf[^ */
 	void inputTS(MemoryChunk data) {
-
-		buffer.add(data);
-
-		if (syncOK) {
-			outPackets();
-		}
-		while (buffer.size() >= CHECK_PACKET_NUM*TS_PACKET_LENGTH) {
-			// `FbN̂ɏ\ȗʂ
-			if (checkSyncByte(buffer.ptr(), CHECK_PACKET_NUM)) {
-				syncOK = true;
-				outPackets();
+		resetCalled = false;
+		size_t offset = 0;
+
+		if (buffer.size() > 0) {
+			// O̎c肪ꍇ́AɕKvȕċE܂
+			size_t carried = buffer.size();
+			size_t added = std::min<size_t>(data.length, LOOKAHEAD_BYTES);
+			buffer.add(MemoryChunk(data.data, added));
+			size_t consumed = parse(buffer.ptr(), buffer.size(), carried);
+			if (resetCalled) {
+				return;
 			}
-			else {
-				// _̂1oCgXLbv
-				syncOK = false;
-				buffer.trimHead(1);
+			if (consumed < carried) {
+				// f[^Ȃiǉf[^܂߂đSăobt@ɂj
+				buffer.trimHead(consumed);
+				return;
 			}
+			buffer.clear();
+			offset = consumed - carried;
 		}
+
+		// c͓̓f[^𒼐ڏ
+		size_t consumed = parse(data.data + offset, data.length - offset, data.length - offset);
+		if (resetCalled) {
+			return;
+		}
+		buffer.add(MemoryChunk(data.data + offset + consumed, data.length - offset - consumed));
 	}
 
 	/** @brief obt@tbV */
 	void flush() {
+		resetCalled = false;
 		while (buffer.size() >= TS_PACKET_LENGTH) {
 			// 擪pPbg̓R[hĂΏo͂
-			if (checkSyncByte(buffer.ptr(), 1))
+			if (checkSyncByte(buffer.ptr(), 1, packetStride))
 			{
-				checkAndOutPacket(MemoryChunk(buffer.ptr(), TS_PACKET_LENGTH));
-				buffer.trimHead(TS_PACKET_LENGTH);
+				checkAndOutPacket(buffer.ptr());
+				if (resetCalled) return;
+				buffer.trimHead(std::min<size_t>(packetStride, buffer.size()));
 			}
 			else {
 				buffer.trimHead(1);
@@ -323,6 +343,13 @@ public:
 	void reset() {
 		buffer.clear();
 		syncOK = false;
+		// onTsPacketĂ΂ꂽꍇɏł؂邽
+		resetCalled = true;
+	}
+
+	/** @brief opPbgԊui188/192/204j */
+	int getPacketStride() const {
+		return packetStride;
 	}
 
 protected:
@@ -330,33 +357,90 @@ protected:
 	virtual void onTsPacket(TsPacket packet) = 0;
 
 private:
+	// ͂̋E܂f[^
 	AutoBuffer buffer;
 	bool syncOK;
+	bool resetCalled;
+	// pPbgԊu
+	// M2TS͓oCg̑OA204oCgTS188oCǧɗ]ȃf[^邪
+	// ǂoCg188oCgTSpPbgȂ̂ŁAԊu΂
+	int packetStride;
 
 	// numPacket̃pPbg̓oCgĂ邩`FbN
-	bool checkSyncByte(uint8_t* ptr, int numPacket) {
+	static bool checkSyncByte(const uint8_t* ptr, int numPacket, int stride) {
 		for (int i = 0; i < numPacket; ++i) {
-			if (ptr[TS_PACKET_LENGTH*i] != TS_SYNC_BYTE) {
+			if (ptr[stride*i] != TS_SYNC_BYTE) {
 				return false;
 			}
 		}
 		return true;
 	}
 
+	// ptr瓯pPbgԊuT
+	// ݂̊ԊuD悵ă`FbN
+	bool detectStride(const uint8_t* ptr) {
+		static const int strides[] = { TS_PACKET_LENGTH, TS_PACKET_LENGTH2, TS_PACKET_LENGTH3 };
+		if (checkSyncByte(ptr, CHECK_PACKET_NUM, packetStride)) {
+			return true;
+		}
+		for (int stride : strides) {
+			if (stride != packetStride && checkSyncByte(ptr, CHECK_PACKET_NUM, stride)) {
+				ctx.infoF("TSpPbg: %doCg", stride);
+				packetStride = stride;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// ptr[0..length)ďoCgԂ
+	// 擪ʒulimitȏɂȂ~߂ilimit͐ǂ݂̂߂Ɏgj
+	// o͔͏ɏ\Ȑǂ݂Ԃł̂ݍŝŁA
+	// ʂ͓͂ǂŋ؂ĂĂɂȂ
+	size_t parse(uint8_t* ptr, size_t length, size_t limit) {
+		size_t pos = 0;
+		if (syncOK) {
+			pos = outPackets(ptr, length, limit, pos);
+			if (resetCalled) return length;
+		}
+		while (pos < limit && length - pos >= LOOKAHEAD_BYTES) {
+			// `FbN̂ɏ\ȗʂ
+			if (detectStride(ptr + pos)) {
+				syncOK = true;
+				pos = outPackets(ptr, length, limit, pos);
+				if (resetCalled) return length;
+			}
+			else {
+				// _̂Ŏ̓oCg܂ŃXLbv
+				// ioCgłȂʒu1oCgĂKŝŌʂ͓j
+				syncOK = false;
+				size_t last = std::min(limit, length - LOOKAHEAD_BYTES + 1);
+				const uint8_t* next = (pos + 1 < last)
+					? (const uint8_t*)memchr(ptr + pos + 1, TS_SYNC_BYTE, last - pos - 1)
+					: nullptr;
+				pos = (next != nullptr) ? (next - ptr) : last;
+			}
+		}
+		return pos;
+	}
+
 	// u擪Ǝ̃pPbg̓oCgčĂΏóvJԂ
-	void outPackets() {
-		while (buffer.size() >= 2 * TS_PACKET_LENGTH &&
-			checkSyncByte(buffer.ptr(), 2))
+	size_t outPackets(uint8_t* ptr, size_t length, size_t limit, size_t pos) {
+		while (pos < limit &&
+			length - pos >= 2 * (size_t)packetStride &&
+			checkSyncByte(ptr + pos, 2, packetStride))
 		{
-			checkAndOutPacket(MemoryChunk(buffer.ptr(), TS_PACKET_LENGTH));
+			checkAndOutPacket(ptr + pos);
 			// onTsPacketresetĂ΂邩Ȃ̂Œ
-			buffer.trimHead(TS_PACKET_LENGTH);
+			if (resetCalled) break;
+			pos += packetStride;
 		}
+		return pos;
 	}
 
 	// pPbg`FbNďo
-	void checkAndOutPacket(MemoryChunk data) {
-		TsPacket packet(data.data);
+	void checkAndOutPacket(uint8_t* data) {
+		TsPacket packet(data);
 		if (packet.parse() && packet.check()) {
 			onTsPacket(packet);
 		}
@@ -34,13 +34,108 @@ public:
 		: AMTObject(ctx)
 		, setting_(setting)
 		, reformInfo_(reformInfo)
-		, audioCache_(ctx, setting.getAudioFilePath(), reformInfo.getAudioFileOffsets(), 12, 4)
+		, audioReader_(ctx, setting.getAudioFilePath(), reformInfo.getAudioFileOffsets())
+		, eoInfo_()
+		, nicoOK_(false)
+		, outFileInfo_(nullptr)
+		, numReady_(0)
+		, runEnabled_(false)
+		, abort_(false)
 	{ }
 
-	void mux(EncodeFileKey key,
+	// muxerɓn
+	struct MuxJob {
+		std::vector<std::pair<tstring, bool>> args;
+		tstring outPath;
+	};
+
+	~AMTMuxder() {
+		// OŔꍇsmuxer͑҂
+		if (workers_ != nullptr) {
+			abort();
+			try {
+				workers_->wait();
+			}
+			catch (...) {}
+		}
+	}
+
+	// SkeyMuxJn
+	// muxer̎s͍őnumParallel[J[XbhŕɍsA
+	// ekeypost()܂ŁAŜwait()Ă΂܂ő҂
+	void start(const std::vector<EncodeFileKey>& keys,
 		const EncoderOptionInfo& eoInfo, // GR[_IvV
 		bool nicoOK,
-		EncodeFileOutput& fileOut) // o͏
+		std::vector<EncodeFileOutput>& outFileInfo, // o͏
+		int numParallel)
+	{
+		keys_ = keys;
+		eoInfo_ = eoInfo;
+		nicoOK_ = nicoOK;
+		outFileInfo_ = &outFileInfo;
+		jobs_.clear();
+		jobs_.resize(keys.size());
+		numReady_ = 0;
+		runEnabled_ = false;
+		abort_ = false;
+
+		int numKeys = (int)keys.size();
+		workers_ = std::unique_ptr<ParallelWorkers>(
+			new ParallelWorkers(std::max(1, std::min(numParallel, numKeys))));
+		workers_->post(numKeys, [this](int threadIndex, int i) {
+			{
+				// ł܂ő҂
+				std::unique_lock<std::mutex> lock(mtx_);
+				while ((numReady_ <= i || !runEnabled_) && !abort_) {
+					cond_.wait(lock);
+				}
+				if (abort_) return;
+			}
+			run(jobs_[i], (*outFileInfo_)[i]);
+		});
+	}
+
+	// keỷt@Cmuxer̎s𓊓
+	// key̏ɌĂԂƁi͂̃Xbhōsj
+	// muxerwait()Ă΂܂ŎsȂ
+	void post() {
+		int i = numReady_;
+		auto key = keys_[i];
+		ctx.infoF("[Mux] %d/%d %s", i + 1, (int)keys_.size(), CMTypeToString(key.cm));
+		try {
+			prepare(key, eoInfo_, nicoOK_, (*outFileInfo_)[i], jobs_[i]);
+		}
+		catch (...) {
+			abort();
+			throw;
+		}
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			++numReady_;
+		}
+		cond_.notify_all();
+	}
+
+	// muxer̎sJnđSkeyMux҂
+	// Muxp\[X(HOST_CMD_Mux)mۂĂĂԂ
+	void wait() {
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			runEnabled_ = true;
+		}
+		cond_.notify_all();
+		auto workers = std::move(workers_);
+		workers->wait();
+	}
+
+private:
+	// muxerɓnt@C
+	// ꎞt@C̃pXo^̂ŌĂяo̓CXbĥ
+	void prepare(EncodeFileKey key,
+		const EncoderOptionInfo& eoInfo,
+		bool nicoOK,
+		EncodeFileOutput& fileOut,
+		MuxJob& job)
 	{
 		const auto& fileIn = reformInfo_.getEncodeFile(key);
 		auto fmt = reformInfo_.getFormat(key);
@@ -78,6 +173,10 @@ public:
 		}
 
 		// t@C쐬
+		Stopwatch sw;
+		sw.start();
+		int64_t readBytes = audioReader_.getReadBytes();
+		int64_t numReads = audioReader_.getNumReads();
 		std::vector<tstring> audioFiles;
 		if (setting_.isEncodeAudio()) {
 			audioFiles.push_back(setting_.getIntAudioFilePath(key, 0));
@@ -95,9 +194,9 @@ public:
 						tstring filepath1 = setting_.getIntAudioFilePath(key, adst++);
 						splitter.open(0, filepath0);
 						splitter.open(1, filepath1);
-						for (int frameIndex : frameList) {
-							splitter.inputPacket(audioCache_[frameIndex]);
-						}
+						audioReader_.readEach(frameList, [&](MemoryChunk mc) {
+							splitter.inputPacket(mc);
+						});
 						audioFiles.push_back(filepath0);
 						audioFiles.push_back(filepath1);
 					}
@@ -107,13 +206,14 @@ public:
 						}
 						tstring filepath = setting_.getIntAudioFilePath(key, adst++);
 						File file(filepath, _T("wb"));
-						for (int frameIndex : frameList) {
-							file.write(audioCache_[frameIndex]);
-						}
+						audioReader_.copyTo(frameList, file);
 						audioFiles.push_back(filepath);
 					}
 				}
 			}
+			ctx.infoF("t@C쐬: %.2fb (ǂݍ %.1fMB %lld)", sw.getAndReset(),
+				(audioReader_.getReadBytes() - readBytes) / (1024.0 * 1024.0),
+				audioReader_.getNumReads() - numReads);
 		}
 
 		// ft@C
@@ -201,14 +301,19 @@ public:
 		// ^CR[hp
 		auto timebase = std::make_pair(vfmt.frameRateNum * (fileOut.vfrTimingFps / 30), vfmt.frameRateDenom);
 
-		auto outPath = setting_.getOutFilePath(fileIn.outKey, fileIn.keyMax);
-		auto args = makeMuxerArgs(
+		job.outPath = setting_.getOutFilePath(fileIn.outKey, fileIn.keyMax);
+		job.args = makeMuxerArgs(
 			setting_.getFormat(),
 			setting_.getMuxerPath(), setting_.getTimelineEditorPath(), setting_.getMp4BoxPath(),
 			encVideoFile, vfmt, audioFiles,
-			outPath, tmpOutPath, chapterFile,
+			job.outPath, tmpOutPath, chapterFile,
 			fileOut.timecode, timebase, subsFiles, subsTitles, metaFile);
+	}
 
+	// muxersiǂ̃XbhĂłj
+	void run(const MuxJob& job, EncodeFileOutput& fileOut)
+	{
+		const auto& args = job.args;
 		for (int i = 0; i < (int)args.size(); ++i) {
 			ctx.infoF("%s", args[i].first);
 			StdRedirectedSubProcess muxer(args[i].first, 0, args[i].second);
@@ -220,11 +325,10 @@ public:
 			ctx.setDefaultCP();
 		}
 
-		File outfile(outPath, _T("rb"));
+		File outfile(job.outPath, _T("rb"));
 		fileOut.fileSize = outfile.size();
 	}
 
-private:
 	class SpDualMonoSplitter : public DualMonoSplitter
 	{
 		std::unique_ptr<File> file[2];
@@ -241,7 +345,28 @@ private:
 	const ConfigWrapper& setting_;
 	const StreamReformInfo& reformInfo_;
 
-	PacketCache audioCache_;
+	PacketStreamReader audioReader_;
+
+	std::vector<EncodeFileKey> keys_;
+	EncoderOptionInfo eoInfo_;
+	bool nicoOK_;
+	std::vector<EncodeFileOutput>* outFileInfo_;
+	std::vector<MuxJob> jobs_;
+	std::unique_ptr<ParallelWorkers> workers_;
+	std::mutex mtx_;
+	std::condition_variable cond_;
+	int numReady_;
+	bool runEnabled_;
+	bool abort_;
+
+	// ܂postĂȂkey͎sȂ悤ɂ
+	void abort() {
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			abort_ = true;
+		}
+		cond_.notify_all();
+	}
 };
 
 class AMTSimpleMuxder : public AMTObject {
@@ -83,6 +83,85 @@ std::vector<std::wstring> GetDirectoryFiles(const std::wstring& dirpath, const s
 	return result;
 }
 
+// ǂݍݐpŃt@CŜ}bv
+class MappedFile : NonCopyable
+{
+public:
+	MappedFile(const tstring& path)
+		: hFile_(INVALID_HANDLE_VALUE)
+		, hMap_(NULL)
+		, ptr_(nullptr)
+		, size_(0)
+	{
+		hFile_ = CreateFileW(to_wstring(path).c_str(), GENERIC_READ, FILE_SHARE_READ,
+			NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (hFile_ == INVALID_HANDLE_VALUE) {
+			THROWF(IOException, "t@CJ܂: %s", path);
+		}
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(hFile_, &size) == 0) {
+			close();
+			THROWF(IOException, "t@CTCY擾Ɏs: %s", path);
+		}
+		size_ = (size_t)size.QuadPart;
+		if (size_ > 0) {
+			// TCY0̃t@C̓}bvłȂ
+			hMap_ = CreateFileMappingW(hFile_, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (hMap_ != NULL) {
+				ptr_ = (uint8_t*)MapViewOfFile(hMap_, FILE_MAP_READ, 0, 0, 0);
+			}
+			if (ptr_ == nullptr) {
+				close();
+				THROWF(IOException, "}bvɎs: %s", path);
+			}
+		}
+	}
+
+	~MappedFile() {
+		close();
+	}
+
+	MemoryChunk get() const {
+		return MemoryChunk(ptr_, size_);
+	}
+
+private:
+	HANDLE hFile_;
+	HANDLE hMap_;
+	uint8_t* ptr_;
+	size_t size_;
+
+	void close() {
+		if (ptr_ != nullptr) {
+			UnmapViewOfFile(ptr_);
+			ptr_ = nullptr;
+		}
+		if (hMap_ != NULL) {
+			CloseHandle(hMap_);
+			hMap_ = NULL;
+		}
+		if (hFile_ != INVALID_HANDLE_VALUE) {
+			CloseHandle(hFile_);
+			hFile_ = INVALID_HANDLE_VALUE;
+		}
+	}
+};
+
+// path̒uhCű󂫗eʁioCgj擾 擾łȂ-1
+int64_t GetFreeDiskSpace(const tstring& path)
+{
+	std::wstring dir = to_wstring(GetFullPath(path));
+	size_t pos = dir.find_last_of(L"/\\");
+	if (pos != std::wstring::npos) {
+		dir = dir.substr(0, pos + 1);
+	}
+	ULARGE_INTEGER freeBytes;
+	if (GetDiskFreeSpaceExW(dir.c_str(), &freeBytes, NULL, NULL) == 0) {
+		return -1;
+	}
+	return (int64_t)freeBytes.QuadPart;
+}
+
 // ݂̃Xbhɐݒ肳ĂRA擾
 int GetProcessorCount()
 {
@@ -86,4 +86,106 @@ private:
 	}
 };
 
+// CfbNXXgɃf[^܂Ƃ߂ēǂݍ
+// t@CŘAf[^1œǂݍ݁A
+// AĂȂf[^obt@ςɂȂ܂ŋl߂Ăn
+class PacketStreamReader : public AMTObject {
+public:
+	PacketStreamReader(
+		AMTContext& ctx,
+		const tstring& filepath,
+		const std::vector<int64_t>& offsets, // f[^+1vf
+		int bufferSize = 4 * 1024 * 1024)
+		: AMTObject(ctx)
+		, file_(filepath, _T("rb"))
+		, offsets_(offsets)
+		, bufferSize_(bufferSize)
+		, filePos_(-1)
+		, readBytes_(0)
+		, numReads_(0)
+	{ }
+
+	// indices̃f[^Ƀobt@ɋl߂
+	// onBlock(f[^, indices̐擪ʒu, f[^)Ă
+	// f[^͎onBlockĂяo܂ŗL
+	template <typename F>
+	void readBlocks(const std::vector<int>& indices, F onBlock) {
+		size_t pos = 0;
+		while (pos < indices.size()) {
+			size_t blockStart = pos;
+			size_t fill = 0;
+			while (pos < indices.size()) {
+				// t@CŘA͈͂obt@ɓ镪
+				int64_t start = offsets_[indices[pos]];
+				size_t end = pos + 1;
+				while (end < indices.size() &&
+					indices[end] == indices[end - 1] + 1 &&
+					offsets_[indices[end] + 1] - start <= (int64_t)(bufferSize_ - fill))
+				{
+					++end;
+				}
+				size_t runBytes = (size_t)(offsets_[indices[end - 1] + 1] - start);
+				if (fill > 0 && fill + runBytes > bufferSize_) {
+					// Ȃ̂Ŏ̃ubNɂ
+					break;
+				}
+				if (buffer_.size() < fill + runBytes) {
+					// 1f[^obt@傫ꍇōL
+					buffer_.resize(fill + runBytes);
+				}
+				readAt(start, MemoryChunk(buffer_.data() + fill, runBytes));
+				fill += runBytes;
+				pos = end;
+			}
+			onBlock(MemoryChunk(buffer_.data(), fill), (int)blockStart, (int)(pos - blockStart));
+		}
+	}
 
+	// indices̃f[^1onData(f[^)ɓn
+	template <typename F>
+	void readEach(const std::vector<int>& indices, F onData) {
+		readBlocks(indices, [&](MemoryChunk block, int first, int num) {
+			uint8_t* ptr = block.data;
+			for (int i = first; i < first + num; ++i) {
+				int size = getDataSize(indices[i]);
+				onData(MemoryChunk(ptr, size));
+				ptr += size;
+			}
+		});
+	}
+
+	// indices̃f[^dstɏ
+	void copyTo(const std::vector<int>& indices, const File& dst) {
+		readBlocks(indices, [&](MemoryChunk block, int first, int num) {
+			dst.write(block);
+		});
+	}
+
+	int getDataSize(int index) const {
+		return int(offsets_[index + 1] - offsets_[index]);
+	}
+
+	int64_t getReadBytes() const { return readBytes_; }
+	int64_t getNumReads() const { return numReads_; }
+
+private:
+	File file_;
+	std::vector<int64_t> offsets_;
+	size_t bufferSize_;
+	std::vector<uint8_t> buffer_;
+	int64_t filePos_; // ݂̃t@CʒuisȂ-1j
+	int64_t readBytes_;
+	int64_t numReads_;
+
+	void readAt(int64_t offset, MemoryChunk mc) {
+		if (offset != filePos_) {
+			file_.seek(offset, SEEK_SET);
+		}
+		if (file_.read(mc) != mc.length) {
+			THROW(IOException, "failed to read packet data");
+		}
+		filePos_ = offset + mc.length;
+		readBytes_ += mc.length;
+		++numReads_;
+	}
+};
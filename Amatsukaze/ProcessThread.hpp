@@ -14,6 +14,9 @@
 #include <string>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
 
 #include "StreamUtils.hpp"
 #include "PerformanceUtil.hpp"
@@ -183,6 +186,525 @@ private:
 	}
 };
 
+// DataPumpThread̒Pvf[TEPRV[}p
+// Œ蒷̃Oobt@ł肷̂ŁA󂯓nƂ̃bNƃmۂȂ
+// XbhN̂̓obt@/tő肪QĂꍇŁA
+// N̂wakeBatch܂/󂭂܂ő҂Ă܂Ƃ߂čs
+// eʁimaximumjamount̍vł͂Ȃvf
+template <typename T, bool PERF = false>
+class SPSCDataPumpThread : private ThreadBase
+{
+public:
+	SPSCDataPumpThread(size_t maximum, size_t wakeBatch = 0)
+		: capacity_(std::max<size_t>(1, maximum))
+		, wakeBatch_(wakeBatch ? std::min(wakeBatch, capacity_) : std::max<size_t>(1, capacity_ / 4))
+		, buffer_(new T[capacity_])
+		, head_(0)
+		, tail_(0)
+		, producerWaiting_(false)
+		, consumerWaiting_(false)
+		, finished_(false)
+		, error_(false)
+	{ }
+
+	~SPSCDataPumpThread() {
+		if (isRunning()) {
+			THROW(InvalidOperationException, "call join() before destroy object ...");
+		}
+	}
+
+	// amountDataPumpThreadƂ̌݊̂߂ŎgȂ
+	void put(T&& data, size_t amount = 1)
+	{
+		if (error_) {
+			THROW(RuntimeException, "DataPumpThread error");
+		}
+		if (finished_) {
+			THROW(InvalidOperationException, "DataPumpThread is already finished");
+		}
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) >= capacity_) {
+			// tȂ̂wakeBatch󂭂܂ő҂
+			if (PERF) producer.start();
+			std::unique_lock<std::mutex> lock(mtx_);
+			producerWaiting_ = true;
+			while (tail - head_ > capacity_ - wakeBatch_) {
+				if (error_) {
+					producerWaiting_ = false;
+					THROW(RuntimeException, "DataPumpThread error");
+				}
+				cond_full_.wait(lock);
+			}
+			producerWaiting_ = false;
+			if (PERF) producer.stop();
+		}
+		buffer_[tail % capacity_] = std::move(data);
+		tail_ = tail + 1;
+		// RV[}QĂwakeBatch܂N
+		if (consumerWaiting_ && tail + 1 - head_ >= wakeBatch_) {
+			std::unique_lock<std::mutex> lock(mtx_);
+			cond_empty_.notify_one();
+		}
+	}
+
+	void start() {
+		head_ = 0;
+		tail_ = 0;
+		finished_ = false;
+		producer.reset();
+		consumer.reset();
+		ThreadBase::start();
+	}
+
+	void join() {
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			finished_ = true;
+			cond_empty_.notify_one();
+		}
+		ThreadBase::join();
+	}
+
+	bool isRunning() { return ThreadBase::isRunning(); }
+
+	void getTotalWait(double& prod, double& cons) {
+		prod = producer.getTotal();
+		cons = consumer.getTotal();
+	}
+
+protected:
+	virtual void OnDataReceived(T&& data) = 0;
+
+private:
+	const size_t capacity_;
+	const size_t wakeBatch_;
+	std::unique_ptr<T[]> buffer_;
+
+	// head_̓RV[}Atail_̓vf[TXV
+	// ҋ@tOƂ̊Ԃseq_cst̏KvȂ̂ŃftHg̃g
+	std::atomic<size_t> head_;
+	std::atomic<size_t> tail_;
+	std::atomic<bool> producerWaiting_;
+	std::atomic<bool> consumerWaiting_;
+	std::atomic<bool> finished_;
+	std::atomic<bool> error_;
+
+	// QƂg
+	std::mutex mtx_;
+	std::condition_variable cond_full_;
+	std::condition_variable cond_empty_;
+
+	Stopwatch producer;
+	Stopwatch consumer;
+
+	virtual void run()
+	{
+		while (true) {
+			size_t head = head_.load(std::memory_order_relaxed);
+			if (tail_.load(std::memory_order_acquire) == head) {
+				// Ȃ̂wakeBatch܂邩I܂ő҂
+				if (PERF) consumer.start();
+				{
+					std::unique_lock<std::mutex> lock(mtx_);
+					consumerWaiting_ = true;
+					while (tail_ - head < wakeBatch_ && !finished_) {
+						cond_empty_.wait(lock);
+					}
+					consumerWaiting_ = false;
+				}
+				if (PERF) consumer.stop();
+				if (tail_ == head) {
+					// finished_ȂI
+					return;
+				}
+			}
+			T data = std::move(buffer_[head % capacity_]);
+			// QƂcȂ悤ɋɂĂ
+			buffer_[head % capacity_] = T();
+			head_ = head + 1;
+			// vf[TQĂwakeBatch󂢂N
+			if (producerWaiting_ && tail_ - (head + 1) <= capacity_ - wakeBatch_) {
+				std::unique_lock<std::mutex> lock(mtx_);
+				cond_full_.notify_one();
+			}
+			if (error_ == false) {
+				try {
+					OnDataReceived(std::move(data));
+				}
+				catch (Exception&) {
+					error_ = true;
+					// tő҂Ăvf[TɃG[`
+					std::unique_lock<std::mutex> lock(mtx_);
+					cond_full_.notify_one();
+				}
+			}
+		}
+	}
+};
+
+// t@CʃXbhŐǂ݂
+// obt@numBuffersg
+class AsyncFileReader : private ThreadBase
+{
+public:
+	AsyncFileReader(const tstring& path, size_t bufferSize, int numBuffers)
+		: file_(path, _T("rb"))
+		, bufferSize_(bufferSize)
+		, current_(-1)
+		, finished_(false)
+		, canceled_(false)
+	{
+		for (int i = 0; i < numBuffers; ++i) {
+			buffers_.emplace_back(new uint8_t[bufferSize]);
+			free_.push_back(i);
+		}
+		fileSize_ = file_.size();
+		ThreadBase::start();
+	}
+
+	~AsyncFileReader() {
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			canceled_ = true;
+			cond_.notify_all();
+		}
+		ThreadBase::join();
+	}
+
+	int64_t size() const {
+		return fileSize_;
+	}
+
+	// ̃f[^擾Bt@CI[Ȃfalse
+	// O擾f[^͂̌ĂяoŖɂȂ
+	bool next(MemoryChunk& mc) {
+		std::unique_lock<std::mutex> lock(mtx_);
+		if (current_ != -1) {
+			free_.push_back(current_);
+			current_ = -1;
+			cond_.notify_all();
+		}
+		while (filled_.size() == 0) {
+			if (errorMessage_.size() > 0) {
+				THROWF(IOException, "t@Cǂݍ݃XbhŃG[: %s", errorMessage_);
+			}
+			if (finished_) return false;
+			consumer_.start();
+			cond_.wait(lock);
+			consumer_.stop();
+		}
+		current_ = filled_.front().first;
+		mc = MemoryChunk(buffers_[current_].get(), filled_.front().second);
+		filled_.pop_front();
+		return true;
+	}
+
+	// ǂݍݎ
+	double getReadTime() const { return read_.getTotal(); }
+	// ǂݍ݃Xbhobt@̋󂫂҂
+	double getProducerWait() const { return producer_.getTotal(); }
+	// ǂݍ݊҂
+	double getConsumerWait() const { return consumer_.getTotal(); }
+
+private:
+	File file_;
+	int64_t fileSize_;
+	size_t bufferSize_;
+	std::vector<std::unique_ptr<uint8_t[]>> buffers_;
+
+	std::mutex mtx_;
+	std::condition_variable cond_;
+	std::deque<std::pair<int, size_t>> filled_;
+	std::deque<int> free_;
+	int current_;
+	bool finished_;
+	bool canceled_;
+	std::string errorMessage_;
+
+	Stopwatch read_;
+	Stopwatch producer_;
+	Stopwatch consumer_;
+
+	virtual void run() {
+		try {
+			while (true) {
+				int index;
+				{
+					std::unique_lock<std::mutex> lock(mtx_);
+					while (free_.size() == 0) {
+						if (canceled_) return;
+						producer_.start();
+						cond_.wait(lock);
+						producer_.stop();
+					}
+					if (canceled_) return;
+					index = free_.front();
+					free_.pop_front();
+				}
+				read_.start();
+				size_t readBytes = file_.read(MemoryChunk(buffers_[index].get(), bufferSize_));
+				read_.stop();
+				std::unique_lock<std::mutex> lock(mtx_);
+				if (readBytes > 0) {
+					filled_.emplace_back(index, readBytes);
+				}
+				if (readBytes < bufferSize_) {
+					finished_ = true;
+				}
+				cond_.notify_all();
+				if (finished_) return;
+			}
+		}
+		catch (const Exception& e) {
+			std::unique_lock<std::mutex> lock(mtx_);
+			errorMessage_ = e.message();
+			cond_.notify_all();
+		}
+	}
+};
+
+// t@C݂ʃXbhōs
+// ȏ݂bufferSize܂ł܂Ƃ߂ĂXbhɓn
+// ݂Iobt@͎g
+class AsyncFileWriter : private DataPumpThread<std::unique_ptr<AutoBuffer>, true>
+{
+	typedef DataPumpThread<std::unique_ptr<AutoBuffer>, true> Base;
+public:
+	AsyncFileWriter(const tstring& path, size_t bufferSize, int numBuffers)
+		: Base(bufferSize * numBuffers)
+		, file_(path, _T("wb"))
+		, bufferSize_(bufferSize)
+		, totalSize_(0)
+	{
+		Base::start();
+	}
+
+	~AsyncFileWriter() {
+		try {
+			close();
+		}
+		catch (const Exception&) {
+			// fXgN^Ȃ̂Ŗ
+		}
+	}
+
+	void write(MemoryChunk mc) {
+		if (mc.length == 0) return;
+		if (current_ == nullptr) {
+			current_ = getBuffer();
+		}
+		current_->add(mc);
+		totalSize_ += mc.length;
+		if (current_->size() >= bufferSize_) {
+			flush();
+		}
+	}
+
+	// c̃f[^SďŃXbhI
+	void close() {
+		if (Base::isRunning()) {
+			// ݃XbhG[ŏIĂflush͗O𓊂邪
+			// Xbh͕KjoinĂG[𓊂
+			std::exception_ptr flushError;
+			try {
+				flush();
+			}
+			catch (...) {
+				flushError = std::current_exception();
+				current_ = nullptr;
+			}
+			Base::join();
+			if (errorMessage_.size() > 0) {
+				THROWF(IOException, "t@C݃XbhŃG[: %s", errorMessage_);
+			}
+			if (flushError) {
+				std::rethrow_exception(flushError);
+			}
+		}
+	}
+
+	int64_t getTotalSize() const {
+		return totalSize_;
+	}
+
+	// ݎ
+	double getWriteTime() const { return write_.getTotal(); }
+	// ݃Xbh̋󂫂҂
+	double getProducerWait() { double prod, cons; getTotalWait(prod, cons); return prod; }
+
+protected:
+	virtual void OnDataReceived(std::unique_ptr<AutoBuffer>&& data) {
+		try {
+			write_.start();
+			file_.write(data->get());
+			write_.stop();
+		}
+		catch (const Exception& e) {
+			errorMessage_ = e.message();
+			throw;
+		}
+		data->clear();
+		std::lock_guard<std::mutex> lock(poolMtx_);
+		pool_.push_back(std::move(data));
+	}
+
+private:
+	File file_;
+	size_t bufferSize_;
+	int64_t totalSize_;
+	std::unique_ptr<AutoBuffer> current_;
+	std::mutex poolMtx_;
+	std::vector<std::unique_ptr<AutoBuffer>> pool_;
+	std::string errorMessage_;
+	Stopwatch write_;
+
+	std::unique_ptr<AutoBuffer> getBuffer() {
+		std::lock_guard<std::mutex> lock(poolMtx_);
+		if (pool_.size() == 0) {
+			return std::unique_ptr<AutoBuffer>(new AutoBuffer());
+		}
+		auto buf = std::move(pool_.back());
+		pool_.pop_back();
+		return buf;
+	}
+
+	void flush() {
+		if (current_ != nullptr && current_->size() > 0) {
+			size_t amount = current_->size();
+			Base::put(std::move(current_), amount);
+		}
+	}
+};
+
+// Œ萔̃[J[Xbhŏs
+// post()œ̊wait()ő҂iwait()܂Ŏpost()͕sj
+// ɔOwait()ōđo
+class ParallelWorkers
+{
+public:
+	ParallelWorkers(int numThreads)
+		: numItems_(0)
+		, nextItem_(0)
+		, numActive_(0)
+		, generation_(0)
+		, quit_(false)
+	{
+		for (int i = 0; i < numThreads; ++i) {
+			workers_.emplace_back(new Worker(this, i));
+		}
+		for (auto& w : workers_) {
+			w->start();
+		}
+	}
+
+	~ParallelWorkers() {
+		{
+			std::unique_lock<std::mutex> lock(mtx_);
+			quit_ = true;
+			cond_.notify_all();
+		}
+		for (auto& w : workers_) {
+			w->join();
+		}
+	}
+
+	int getNumThreads() const {
+		return (int)workers_.size();
+	}
+
+	// func(threadIndex, itemIndex)itemIndex=0..numItems-1ɂĕɌĂяo
+	void post(int numItems, const std::function<void(int, int)>& func) {
+		std::unique_lock<std::mutex> lock(mtx_);
+		if (numActive_ > 0) {
+			THROW(InvalidOperationException, "call wait() before next post() ...");
+		}
+		func_ = func;
+		numItems_ = numItems;
+		nextItem_ = 0;
+		numActive_ = (int)workers_.size();
+		++generation_;
+		cond_.notify_all();
+	}
+
+	void wait() {
+		std::unique_lock<std::mutex> lock(mtx_);
+		while (numActive_ > 0) {
+			condDone_.wait(lock);
+		}
+		func_ = nullptr;
+		if (error_) {
+			std::exception_ptr error = error_;
+			error_ = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	void run(int numItems, const std::function<void(int, int)>& func) {
+		post(numItems, func);
+		wait();
+	}
+
+private:
+	class Worker : public ThreadBase {
+	public:
+		Worker(ParallelWorkers* pool, int index) : pool_(pool), index_(index) { }
+	protected:
+		virtual void run() { pool_->workerLoop(index_); }
+	private:
+		ParallelWorkers* pool_;
+		int index_;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+
+	std::mutex mtx_;
+	std::condition_variable cond_;
+	std::condition_variable condDone_;
+
+	std::function<void(int, int)> func_;
+	int numItems_;
+	std::atomic<int> nextItem_;
+	int numActive_;
+	int generation_;
+	bool quit_;
+	std::exception_ptr error_;
+
+	void workerLoop(int threadIndex) {
+		int seen = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mtx_);
+				while (generation_ == seen && !quit_) {
+					cond_.wait(lock);
+				}
+				if (quit_) return;
+				seen = generation_;
+			}
+			while (true) {
+				int item = nextItem_++;
+				if (item >= numItems_) break;
+				try {
+					func_(threadIndex, item);
+				}
+				catch (...) {
+					std::unique_lock<std::mutex> lock(mtx_);
+					if (!error_) {
+						error_ = std::current_exception();
+					}
+					// c͂Ȃ
+					nextItem_ = numItems_;
+				}
+			}
+			{
+				std::unique_lock<std::mutex> lock(mtx_);
+				if (--numActive_ == 0) {
+					condDone_.notify_all();
+				}
+			}
+		}
+	}
+};
+
 class SubProcess
 {
 public:
@@ -157,6 +157,13 @@ struct FilterAudioFrame {
 	int frameIndex; // fobOp
 	int64_t waveOffset;
 	int waveLength;
+	// ԉt@Cł̈ʒuiwavet@CȂƂ͂fR[hj
+	int64_t codedOffset;
+	int codedLength;
+	// Xg[̒Õt[̒ԉt@Cł̈ʒuiȂ-1j
+	// rfR[hƂ̓fR[_̃t[Ŋ炷
+	int64_t prevCodedOffset;
+	int prevCodedLength;
 };
 
 struct FilterOutVideoInfo {
@@ -409,12 +416,7 @@ public:
 	std::vector<FilterAudioFrame> getWaveInput(const std::vector<int>& frameList) const {
 		std::vector<FilterAudioFrame> ret;
 		for (int i = 0; i < (int)frameList.size(); ++i) {
-			FilterAudioFrame frame = { 0 };
-			auto& info = audioFrameList_[frameList[i]];
-			frame.frameIndex = frameList[i];
-			frame.waveOffset = info.waveOffset;
-			frame.waveLength = info.waveDataSize;
-			ret.push_back(frame);
+			ret.push_back(makeFilterAudioFrame(frameList[i]));
 		}
 		return ret;
 	}
@@ -1208,16 +1210,32 @@ private:
 
 			auto& list = file.audioFrameList[0];
 			for (int i = 0; i < (int)list.size(); ++i) {
-				FilterAudioFrame frame = { 0 };
-				auto& info = audioFrameList_[list[i]];
-				frame.frameIndex = list[i];
-				frame.waveOffset = info.waveOffset;
-				frame.waveLength = info.waveDataSize;
-				filterAudioFrameList_[videoId].push_back(frame);
+				filterAudioFrameList_[videoId].push_back(makeFilterAudioFrame(list[i]));
 			}
 		}
 	}
 
+	FilterAudioFrame makeFilterAudioFrame(int index) const {
+		FilterAudioFrame frame = { 0 };
+		auto& info = audioFrameList_[index];
+		frame.frameIndex = index;
+		frame.waveOffset = info.waveOffset;
+		frame.waveLength = info.waveDataSize;
+		frame.codedOffset = info.fileOffset;
+		frame.codedLength = info.codedDataSize;
+		frame.prevCodedOffset = -1;
+		frame.prevCodedLength = 0;
+		// Xg[̓C^[uĂ̂œXg[̃t[T
+		for (int i = index - 1; i >= 0; --i) {
+			if (audioFrameList_[i].audioIdx == info.audioIdx) {
+				frame.prevCodedOffset = audioFrameList_[i].fileOffset;
+				frame.prevCodedLength = audioFrameList_[i].codedDataSize;
+				break;
+			}
+		}
+		return frame;
+	}
+
 	// \[Xt[̕\
 	// index, nextIndex: DTS
 	double getSourceFrameDuration(int index, int nextIndex) {
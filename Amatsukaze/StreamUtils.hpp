@@ -12,6 +12,8 @@
 #include <array>
 #include <map>
 #include <set>
+#include <mutex>
+#include <atomic>
 #include <fstream>
 #include <cctype>
 #include <locale>
@@ -25,7 +27,8 @@ enum {
 	TS_SYNC_BYTE = 0x47,
 
 	TS_PACKET_LENGTH = 188,
-	TS_PACKET_LENGTH2 = 192,
+	TS_PACKET_LENGTH2 = 192, // M2TSi擪4oCg̃^CX^vj
+	TS_PACKET_LENGTH3 = 204, // 16oCg̃[h\
 
 	MAX_PID = 0x1FFF,
 
@@ -391,11 +394,14 @@ public:
 		printProgress(StringFormat(fmt, args ...).c_str());
 	}
 
+	// ̓XbhĂ΂̂ŃbN
 	void registerTmpFile(const tstring& path) {
+		std::lock_guard<std::mutex> lock(tmpFilesMutex);
 		tmpFiles.insert(path);
 	}
 
 	void clearTmpFiles() {
+		std::lock_guard<std::mutex> lock(tmpFilesMutex);
 		for (auto& path : tmpFiles) {
 			if (path.find(_T('*')) != tstring::npos) {
 				auto dir = pathGetDirectory(path);
@@ -411,6 +417,7 @@ public:
 		tmpFiles.clear();
 	}
 
+	// ̓XbhĂ΂̂ŃJE^atomic
 	void incrementCounter(AMT_ERROR_COUNTER err) {
 		errCounter[err]++;
 	}
@@ -473,8 +480,9 @@ private:
 	CRC32 crc;
 	int acp;
 
+	std::mutex tmpFilesMutex;
 	std::set<tstring> tmpFiles;
-	std::array<int, AMT_ERR_MAX> errCounter;
+	std::array<std::atomic<int>, AMT_ERR_MAX> errCounter;
 	std::string errMessage;
 
 	std::map<std::string, std::wstring> drcsMap;
@@ -527,11 +535,15 @@ struct DecoderSetting {
 	DECODER_TYPE mpeg2;
 	DECODER_TYPE h264;
 	DECODER_TYPE hevc;
+	int numDecoders; // AMTSourceŕɎgfR[_
+	int cacheBudgetMB; // AMTSourcẽt[LbV̏(MB) 0Ȃ疇݂̂Ő
 
 	DecoderSetting()
 		: mpeg2(DECODER_DEFAULT)
 		, h264(DECODER_DEFAULT)
 		, hevc(DECODER_DEFAULT)
+		, numDecoders(1)
+		, cacheBudgetMB(0)
 	{ }
 };
 
@@ -799,6 +811,8 @@ struct AudioFrameData : public AudioFrameInfo {
 	int numDecodedSamples;
 	int decodedDataSize;
 	uint16_t* decodedData;
+	// truêƂ͂܂fR[hĂȂidecodedDataNULLAdecodedDataSize̓fR[h̃TCYj
+	bool decodeDeferred;
 };
 
 class IVideoParser {
@@ -31,9 +31,7 @@ public:
 		: TsSplitter(ctx, true, true, setting.isSubtitlesEnabled())
 		, setting_(setting)
 		, psWriter(ctx)
-		, writeHandler(*this)
-		, audioFile_(setting.getAudioFilePath(), _T("wb"))
-		, waveFile_(setting.getWaveFilePath(), _T("wb"))
+		, writeHandler(*this, setting.isParallelDemux())
 		, curVideoFormat_()
 		, videoFileCount_(0)
 		, videoStreamType_(-1)
@@ -43,6 +41,31 @@ public:
 		, srcFileSize_(0)
 	{
 		psWriter.setHandler(&writeHandler);
+		if (setting.isParallelDemux()) {
+			audioWriter_ = std::unique_ptr<AsyncFileWriter>(
+				new AsyncFileWriter(setting.getAudioFilePath(), WRITE_BUFSIZE, WRITE_NUM_BUFFERS));
+			// wave͉Xg[Ƃ̃fR[hXbh
+			setDeferAudioDecode(true);
+		}
+		else {
+			audioFile_ = std::unique_ptr<File>(new File(setting.getAudioFilePath(), _T("wb")));
+		}
+		if (setting.isLazyWave()) {
+			// wave͍Ȃ̂ŃtH[}bg΃fR[hsv
+			setDeferAudioDecode(true);
+		}
+		else {
+			waveFile_ = std::unique_ptr<File>(new File(setting.getWaveFilePath(), _T("wb")));
+		}
+	}
+
+	~AMTSplitter() {
+		// OŔꍇXbh͎~߂
+		for (auto& decoder : audioDecoders_) {
+			if (decoder != nullptr) {
+				decoder->join();
+			}
+		}
 	}
 
 	StreamReformInfo split()
@@ -65,36 +88,126 @@ public:
 	}
 
 protected:
+	enum {
+		READ_BUFSIZE = 4 * 1024 * 1024,
+		READ_NUM_BUFFERS = 4,
+		WRITE_BUFSIZE = 1024 * 1024,
+		WRITE_NUM_BUFFERS = 8,
+		// fR[hXbhɗ߂ĂőoCgiXg[Ɓj
+		AUDIO_DECODE_BUFSIZE = 4 * 1024 * 1024,
+	};
+
+	struct AudioDecodeTask {
+		std::vector<uint8_t> codedData;
+		int frameIdx; // audioFrameList_ł̃CfbNX
+		int64_t waveOffset;
+		int waveDataSize;
+	};
+
+	// Xg[1waveo͗pfR[hXbh
+	// fR[hf[^TS͎Ɍ߂ʒuɏ
+	// fR[hłȂt[͋L^Ăĉ͌Ɏ̂Ă
+	class AudioDecodeThread : public DataPumpThread<std::unique_ptr<AudioDecodeTask>> {
+	public:
+		AudioDecodeThread(AMTSplitter& this_)
+			: DataPumpThread(AUDIO_DECODE_BUFSIZE)
+			, this_(this_)
+			, decoder(this_.ctx)
+			, numChannelErrors(0)
+			, decodeTime(0)
+		{ }
+		// 2chɂłȂt[i͂ŃG[ƂĐ́j
+		int getNumChannelErrors() const { return numChannelErrors; }
+		const std::vector<int>& getFailedFrames() const { return failedFrames; }
+		double getDecodeTime() const { return decodeTime; }
+	protected:
+		virtual void OnDataReceived(std::unique_ptr<AudioDecodeTask>&& task) {
+			Stopwatch sw;
+			sw.start();
+			NeAACDecFrameInfo frameInfo;
+			void* samples;
+			bool channelError;
+			bool ok = decoder.decode(task->codedData.data(),
+				(int)task->codedData.size(), frameInfo, samples, channelError);
+			decodeTime += sw.getAndReset();
+			if (ok && (int)frameInfo.samples * 2 == task->waveDataSize) {
+				this_.writeWave(task->waveOffset, MemoryChunk((uint8_t*)samples, task->waveDataSize));
+			}
+			else {
+				// ͂ł̓p[To͂Ȃt[Ȃ̂ŌŎ̂Ă
+				//iTCYȂꍇ͉͎̈ʒuɏ߂Ȃ̂œ̂Ăj
+				if (channelError) {
+					++numChannelErrors;
+				}
+				failedFrames.push_back(task->frameIdx);
+			}
+		}
+	private:
+		AMTSplitter& this_;
+		AdtsDecoder decoder;
+		std::vector<int> failedFrames;
+		int numChannelErrors;
+		double decodeTime;
+	};
+
 	class StreamFileWriteHandler : public PsStreamWriter::EventHandler {
 		TsSplitter& this_;
+		bool async_;
 		std::unique_ptr<File> file_;
+		std::unique_ptr<AsyncFileWriter> writer_;
 		int64_t totalIntVideoSize_;
+		double writeTime_;
+		double waitTime_;
 	public:
-		StreamFileWriteHandler(TsSplitter& this_)
-			: this_(this_), totalIntVideoSize_() { }
+		StreamFileWriteHandler(TsSplitter& this_, bool async)
+			: this_(this_), async_(async), totalIntVideoSize_(), writeTime_(), waitTime_() { }
 		virtual void onStreamData(MemoryChunk mc) {
-			if (file_ != NULL) {
+			if (writer_ != NULL) {
+				writer_->write(mc);
+				totalIntVideoSize_ += mc.length;
+			}
+			else if (file_ != NULL) {
 				file_->write(mc);
 				totalIntVideoSize_ += mc.length;
 			}
 		}
 		void open(const tstring& path) {
+			close();
 			totalIntVideoSize_ = 0;
-			file_ = std::unique_ptr<File>(new File(path, _T("wb")));
+			if (async_) {
+				writer_ = std::unique_ptr<AsyncFileWriter>(
+					new AsyncFileWriter(path, WRITE_BUFSIZE, WRITE_NUM_BUFFERS));
+			}
+			else {
+				file_ = std::unique_ptr<File>(new File(path, _T("wb")));
+			}
 		}
 		void close() {
+			if (writer_ != NULL) {
+				writer_->close();
+				writeTime_ += writer_->getWriteTime();
+				waitTime_ += writer_->getProducerWait();
+				writer_ = nullptr;
+			}
 			file_ = nullptr;
 		}
 		int64_t getTotalSize() const {
 			return totalIntVideoSize_;
 		}
+		// 񓯊݂̓viSt@Cvj
+		double getWriteTime() const { return writeTime_; }
+		double getWaitTime() const { return waitTime_; }
 	};
 
 	const ConfigWrapper& setting_;
 	PsStreamWriter psWriter;
 	StreamFileWriteHandler writeHandler;
-	File audioFile_;
-	File waveFile_;
+	std::unique_ptr<File> audioFile_;
+	std::unique_ptr<File> waveFile_;
+	// TS͗p
+	std::unique_ptr<AsyncFileWriter> audioWriter_;
+	std::vector<std::unique_ptr<AudioDecodeThread>> audioDecoders_;
+	std::mutex waveMutex_;
 	VideoFormat curVideoFormat_;
 
 	int videoFileCount_;
@@ -112,9 +225,12 @@ protected:
 	std::vector<std::pair<int64_t, JSTTime>> timeList_;
 
 	void readAll() {
-		enum { BUFSIZE = 4 * 1024 * 1024 };
-		auto buffer_ptr = std::unique_ptr<uint8_t[]>(new uint8_t[BUFSIZE]);
-		MemoryChunk buffer(buffer_ptr.get(), BUFSIZE);
+		if (setting_.isParallelDemux()) {
+			readAllParallel();
+			return;
+		}
+		auto buffer_ptr = std::unique_ptr<uint8_t[]>(new uint8_t[READ_BUFSIZE]);
+		MemoryChunk buffer(buffer_ptr.get(), READ_BUFSIZE);
 		File srcfile(setting_.getSrcFilePath(), _T("rb"));
 		srcFileSize_ = srcfile.size();
 		size_t readBytes;
@@ -124,6 +240,124 @@ protected:
 		} while (readBytes == buffer.length);
 	}
 
+	// ǂݍ݁ÁA݁ifAjꂼʃXbhōs
+	// ͂͂̃Xbhōs
+	// wave̓`l\wb_ŕXg[Ȃ特Xg[Ƃ̃XbhŃfR[hď
+	// ܂f[^͏Ԃ܂߂readAll()Ɠ
+	// iAfR[hłȂt[̃f[^͎QƂȂ܂ܒԃt@CɎcj
+	void readAllParallel() {
+		Stopwatch sw;
+		sw.start();
+		double readTime, readWait;
+		{
+			AsyncFileReader reader(setting_.getSrcFilePath(), READ_BUFSIZE, READ_NUM_BUFFERS);
+			srcFileSize_ = reader.size();
+			MemoryChunk buffer;
+			while (reader.next(buffer)) {
+				inputTsData(buffer);
+			}
+			readTime = reader.getReadTime();
+			readWait = reader.getConsumerWait();
+		}
+		// ݊҂
+		writeHandler.close();
+		audioWriter_->close();
+		double total = sw.getAndReset();
+		// wavẽfR[h҂
+		double decodeTime = 0;
+		int numChannelErrors = 0;
+		std::vector<int> failedFrames;
+		for (auto& decoder : audioDecoders_) {
+			if (decoder != nullptr) {
+				decoder->join();
+				decodeTime += decoder->getDecodeTime();
+				numChannelErrors += decoder->getNumChannelErrors();
+				failedFrames.insert(failedFrames.end(),
+					decoder->getFailedFrames().begin(), decoder->getFailedFrames().end());
+			}
+		}
+		double decodeWait = sw.getAndReset();
+		for (int i = 0; i < numChannelErrors; ++i) {
+			ctx.incrementCounter(AMT_ERR_DECODE_AUDIO);
+		}
+		if (numChannelErrors > 0) {
+			ctx.warnF("t[𐳂fR[hł܂łi%dt[j", numChannelErrors);
+		}
+		if (failedFrames.size() > 0) {
+			ctx.infoF("fR[hłȂt[%dt[O", (int)failedFrames.size());
+			dropAudioFrames(failedFrames);
+		}
+
+		double writeWait = writeHandler.getWaitTime() + audioWriter_->getProducerWait();
+		ctx.infoF("TS ǂݍ: %.2fb : %.2fb (ǂݍݑ҂: %.2fb ݑ҂: %.2fb)",
+			readTime, total - readWait - writeWait, readWait, writeWait);
+		ctx.infoF("TS  f: %.2fb : %.2fb",
+			writeHandler.getWriteTime(), audioWriter_->getWriteTime());
+		ctx.infoF("TS fR[h: %.2fb (͌̑҂: %.2fb)", decodeTime, decodeWait);
+	}
+
+	void writeAudio(MemoryChunk mc) {
+		if (audioWriter_ != NULL) {
+			audioWriter_->write(mc);
+		}
+		else {
+			audioFile_->write(mc);
+		}
+	}
+
+	// offsetwavet@Cł̈ʒu
+	// fR[hXbhꍇ͏ݏOシ̂ňʒuw肵ď
+	void writeWave(int64_t offset, MemoryChunk mc) {
+		if (setting_.isParallelDemux()) {
+			std::lock_guard<std::mutex> lock(waveMutex_);
+			waveFile_->seek(offset, SEEK_SET);
+			waveFile_->write(mc);
+		}
+		else {
+			waveFile_->write(mc);
+		}
+	}
+
+	// fR[hłȂt[Xg珜
+	// ͂Ńp[Tt[o͂ȂꍇƓɂȂ悤
+	// tH[}bgύXCxg͏t[̎̃t[w悤ɂ
+	void dropAudioFrames(std::vector<int>& frames) {
+		std::sort(frames.begin(), frames.end());
+		for (auto& ev : streamEventList_) {
+			if (ev.type == AUDIO_FORMAT_CHANGED) {
+				int numDropped = int(std::lower_bound(frames.begin(), frames.end(), ev.frameIdx) - frames.begin());
+				ev.frameIdx -= numDropped;
+			}
+		}
+		int dst = 0;
+		auto it = frames.begin();
+		for (int i = 0; i < (int)audioFrameList_.size(); ++i) {
+			if (it != frames.end() && *it == i) {
+				++it;
+				continue;
+			}
+			audioFrameList_[dst++] = audioFrameList_[i];
+		}
+		audioFrameList_.resize(dst);
+	}
+
+	void postAudioDecode(int audioIdx, const AudioFrameData& frame, int64_t waveOffset) {
+		if ((int)audioDecoders_.size() <= audioIdx) {
+			audioDecoders_.resize(audioIdx + 1);
+		}
+		auto& decoder = audioDecoders_[audioIdx];
+		if (decoder == nullptr) {
+			decoder = std::unique_ptr<AudioDecodeThread>(new AudioDecodeThread(*this));
+			decoder->start();
+		}
+		auto task = std::unique_ptr<AudioDecodeTask>(new AudioDecodeTask());
+		task->codedData.assign(frame.codedData, frame.codedData + frame.codedDataSize);
+		task->frameIdx = (int)audioFrameList_.size();
+		task->waveOffset = waveOffset;
+		task->waveDataSize = frame.decodedDataSize;
+		decoder->put(std::move(task), frame.codedDataSize);
+	}
+
 	static bool CheckPullDown(PICTURE_TYPE p0, PICTURE_TYPE p1) {
 		switch (p0) {
 		case PIC_TFF:
@@ -278,9 +512,15 @@ protected:
 			info.waveDataSize = frame.decodedDataSize;
 			info.fileOffset = audioFileSize_;
 			info.waveOffset = waveFileSize_;
-			audioFile_.write(MemoryChunk(frame.codedData, frame.codedDataSize));
-			if (frame.decodedDataSize > 0) {
-				waveFile_.write(MemoryChunk((uint8_t*)frame.decodedData, frame.decodedDataSize));
+			writeAudio(MemoryChunk(frame.codedData, frame.codedDataSize));
+			if (waveFile_ == nullptr) {
+				// wave͕KvɂȂƂɒԉt@CfR[h
+			}
+			else if (frame.decodeDeferred) {
+				postAudioDecode(audioIdx, frame, waveFileSize_);
+			}
+			else if (frame.decodedDataSize > 0) {
+				writeWave(waveFileSize_, MemoryChunk((uint8_t*)frame.decodedData, frame.decodedDataSize));
 			}
 			audioFileSize_ += frame.codedDataSize;
 			waveFileSize_ += frame.decodedDataSize;
@@ -548,31 +788,53 @@ static void transcodeMain(AMTContext& ctx, const ConfigWrapper& setting)
 		auto amtsPath = setting.getTmpAMTSourcePath(videoFileIndex);
 		av::SaveAMTSource(amtsPath,
 			setting.getIntVideoFilePath(videoFileIndex),
-			setting.getWaveFilePath(),
+			setting.isLazyWave() ? tstring() : setting.getWaveFilePath(),
+			setting.getAudioFilePath(),
 			fmt.videoFormat, fmt.audioFormat[0],
 			reformInfo.getFilterSourceFrames(videoFileIndex),
 			reformInfo.getFilterSourceAudioFrames(videoFileIndex),
-			setting.getDecoderSetting());
+			setting.getDecoderSetting(),
+			setting.getIntVideoGopIndexPath(videoFileIndex));
 	}
 
 	// SECM
-	rm.wait(HOST_CMD_CMAnalyze);
+	auto cmRes = rm.wait(HOST_CMD_CMAnalyze);
 	sw.start();
 	std::vector<std::pair<size_t, bool>> logoFound;
 	std::vector<std::unique_ptr<MakeChapter>> chapterMakers(numVideoFiles);
+	std::vector<bool> isAnalyze(numVideoFiles);
 	for (int videoFileIndex = 0; videoFileIndex < numVideoFiles; ++videoFileIndex) {
 		size_t numFrames = reformInfo.getFilterSourceFrames(videoFileIndex).size();
 		// `v^[͂300t[i10bjȏ゠ꍇ
 		//iZƃG[ɂȂ邱Ƃ̂Łj
-		bool isAnalyze = (setting.isChapterEnabled() && numFrames >= 300);
-
-		cmanalyze.emplace_back(std::unique_ptr<CMAnalyze>(isAnalyze 
-			? new CMAnalyze(ctx, setting, videoFileIndex, numFrames) 
-			: new CMAnalyze(ctx, setting)));
-
-		CMAnalyze* cma = cmanalyze.back().get();
+		isAnalyze[videoFileIndex] = (setting.isChapterEnabled() && numFrames >= 300);
+	}
+	{
+		// ft@CƂ͓̉͂ƗĂ̂œɎs
+		// ԃt@C͉ft@CƂɕʂŁActxւ̈ꎞt@Co^ƃG[JEg̓XbhZ[t
+		// ʂcmanalyze[videoFileIndex]ɓ邾ŁAf͌ł̃Xbhōs
+		// s͊蓖ĂꂽCPUiw肪ꍇj𒴂Ȃ悤ɂ
+		int numParallel = std::max(1, std::min(setting.getMaxCMAnalyzeParallel(), numVideoFiles));
+		if (cmRes.mask != 0) {
+			int numCPUs = 0;
+			for (uint64_t m = cmRes.mask; m != 0; m &= m - 1) ++numCPUs;
+			numParallel = std::max(1, std::min(numParallel, numCPUs));
+		}
+		cmanalyze.resize(numVideoFiles);
+		ParallelWorkers workers(numParallel);
+		workers.run(numVideoFiles, [&](int threadIndex, int videoFileIndex) {
+			size_t numFrames = reformInfo.getFilterSourceFrames(videoFileIndex).size();
+			cmanalyze[videoFileIndex] = std::unique_ptr<CMAnalyze>(isAnalyze[videoFileIndex]
+				? new CMAnalyze(ctx, setting, videoFileIndex, (int)numFrames)
+				: new CMAnalyze(ctx, setting));
+		});
+	}
+	// ʂ̔f͍܂Œʂt@Cɍs
+	for (int videoFileIndex = 0; videoFileIndex < numVideoFiles; ++videoFileIndex) {
+		size_t numFrames = reformInfo.getFilterSourceFrames(videoFileIndex).size();
+		CMAnalyze* cma = cmanalyze[videoFileIndex].get();
 
-		if (isAnalyze && setting.isPmtCutEnabled()) {
+		if (isAnalyze[videoFileIndex] && setting.isPmtCutEnabled()) {
 			// PMTύXɂCMǉF
 			cma->applyPmtCut(numFrames, setting.getPmtCutSideRate(),
 				reformInfo.getPidChangedList(videoFileIndex));
@@ -588,7 +850,7 @@ static void transcodeMain(AMTContext& ctx, const ConfigWrapper& setting)
 		logoFound.emplace_back(numFrames, cma->getLogoPath().size() > 0);
 		reformInfo.applyCMZones(videoFileIndex, cma->getZones(), cma->getDivs());
 
-		if (isAnalyze) {
+		if (isAnalyze[videoFileIndex]) {
 			chapterMakers[videoFileIndex] = std::unique_ptr<MakeChapter>(
 				new MakeChapter(ctx, setting, reformInfo, videoFileIndex, cma->getTrims()));
 		}
@@ -673,12 +935,19 @@ static void transcodeMain(AMTContext& ctx, const ConfigWrapper& setting)
 				outpath);
 			auto format = reformInfo.getFormat(key);
 			auto audioFrames = reformInfo.getWaveInput(reformInfo.getEncodeFile(key).audioFrames[0]);
-			EncodeAudio(ctx, args, setting.getWaveFilePath(), format.audioFormat[0], audioFrames);
+			EncodeAudio(ctx, args,
+				setting.isLazyWave() ? tstring() : setting.getWaveFilePath(),
+				setting.getAudioFilePath(), format.audioFormat[0], audioFrames);
 		}
 	}
 
 	auto argGen = std::unique_ptr<EncoderArgumentGenerator>(new EncoderArgumentGenerator(setting, reformInfo));
 
+	// GR[hIkey珇Muxp̃t@CĂ
+	// muxer̎sMuxp\[XmۂĂ
+	auto muxer = std::unique_ptr<AMTMuxder>(new AMTMuxder(ctx, setting, reformInfo));
+	muxer->start(keys, eoInfo, nicoOK, outFileInfo, setting.getMaxMuxParallel());
+
 	sw.start();
 	for (int i = 0; i < (int)keys.size(); ++i) {
 		auto key = keys[i];
@@ -743,13 +1012,23 @@ static void transcodeMain(AMTContext& ctx, const ConfigWrapper& setting)
 						outfmt, bitrateZones, vfrBitrateScale,
 						fileOut.timecode, fileOut.vfrTimingFps, key, pass[i]));
 			}
+			tstring cachePath;
+			if (setting.isFilterCache() && pass.size() > 1) {
+				cachePath = setting.getFilterCachePath(key);
+			}
 			AMTFilterVideoEncoder encoder(ctx, std::max(4, setting.getNumEncodeBufferFrames()));
 			encoder.encode(filterClip, outfmt,
-				timeCodes, encoderArgs, env);
+				timeCodes, encoderArgs, env, cachePath, setting.isFilterCacheMmap());
+			if (cachePath.size() > 0) {
+				// 傫̂ŎgI炷ɏ
+				removeT(cachePath.c_str());
+			}
 		}
 		catch (const AvisynthError& avserror) {
 			THROWF(AviSynthException, "%s", avserror.msg);
 		}
+
+		muxer->post();
 	}
 	ctx.infoF("GR[h: %.2fb", sw.getAndReset());
 
@@ -758,13 +1037,8 @@ static void transcodeMain(AMTContext& ctx, const ConfigWrapper& setting)
 	rm.wait(HOST_CMD_Mux);
 	sw.start();
 	int64_t totalOutSize = 0;
-	auto muxer = std::unique_ptr<AMTMuxder>(new AMTMuxder(ctx, setting, reformInfo));
+	muxer->wait();
 	for (int i = 0; i < (int)keys.size(); ++i) {
-		auto key = keys[i];
-
-		ctx.infoF("[MuxJn] %d/%d %s", i + 1, (int)keys.size(), CMTypeToString(key.cm));
-		muxer->mux(key, eoInfo, nicoOK, outFileInfo[i]);
-
 		totalOutSize += outFileInfo[i].fileSize;
 	}
 	ctx.infoF("Mux: %.2fb", sw.getAndReset());
@@ -531,6 +531,8 @@ struct Config {
 	ENUM_FORMAT format;
 	bool splitSub;
 	bool twoPass;
+	bool filterCache;
+	bool filterCacheMmap;
 	bool autoBitrate;
 	bool chapter;
 	bool subtitles;
@@ -544,6 +546,12 @@ struct Config {
 	DecoderSetting decoderSetting;
 	int audioBitrateInKbps;
 	int numEncodeBufferFrames;
+	bool parallelDemux;
+	bool lazyWave;
+	int numLogoScanThreads;
+	bool reuseLogoAnalysis;
+	int maxCMAnalyzeParallel;
+	int maxMuxParallel;
 	// CM͗pݒ
 	std::vector<tstring> logoPath;
 	std::vector<tstring> eraseLogoPath;
@@ -686,6 +694,14 @@ public:
 		return conf.twoPass;
 	}
 
+	bool isFilterCache() const {
+		return conf.filterCache;
+	}
+
+	bool isFilterCacheMmap() const {
+		return conf.filterCacheMmap;
+	}
+
 	bool isAutoBitrate() const {
 		return conf.autoBitrate;
 	}
@@ -742,6 +758,30 @@ public:
 		return conf.numEncodeBufferFrames;
 	}
 
+	bool isParallelDemux() const {
+		return conf.parallelDemux;
+	}
+
+	bool isLazyWave() const {
+		return conf.lazyWave;
+	}
+
+	int getNumLogoScanThreads() const {
+		return conf.numLogoScanThreads;
+	}
+
+	bool isReuseLogoAnalysis() const {
+		return conf.reuseLogoAnalysis;
+	}
+
+	int getMaxCMAnalyzeParallel() const {
+		return conf.maxCMAnalyzeParallel;
+	}
+
+	int getMaxMuxParallel() const {
+		return conf.maxMuxParallel;
+	}
+
 	const std::vector<tstring>& getLogoPath() const {
 		return conf.logoPath;
 	}
@@ -858,6 +898,10 @@ public:
 		return regtmp(StringFormat(_T("%s/i%d.mpg"), tmpDir.path(), index));
 	}
 
+	tstring getIntVideoGopIndexPath(int index) const {
+		return regtmp(StringFormat(_T("%s/i%d.gop"), tmpDir.path(), index));
+	}
+
 	tstring getStreamInfoPath() const {
 		return conf.outVideoPath + _T("-streaminfo.dat");
 	}
@@ -938,6 +982,13 @@ public:
 		return regtmp(StringFormat(_T("%s/logof%d-%d.txt"), tmpDir.path(), vindex, logoIndex));
 	}
 
+	tstring getTmpLogoAnalysisPath(int vindex, int logoIndex = -1) const {
+		if (logoIndex == -1) {
+			return regtmp(StringFormat(_T("%s/logoa%d.dat"), tmpDir.path(), vindex));
+		}
+		return regtmp(StringFormat(_T("%s/logoa%d-%d.dat"), tmpDir.path(), vindex, logoIndex));
+	}
+
 	tstring getTmpChapterExePath(int vindex) const {
 		return regtmp(StringFormat(_T("%s/chapter_exe%d.txt"), tmpDir.path(), vindex));
 	}
@@ -976,6 +1027,11 @@ public:
 			tmpDir.path(), key.video, key.format, key.div, GetCMSuffix(key.cm), GetNicoJKSuffix(type)));
 	}
 
+	tstring getFilterCachePath(EncodeFileKey key) const {
+		return regtmp(StringFormat(_T("%s/fc%d-%d-%d%s.dat"),
+			tmpDir.path(), key.video, key.format, key.div, GetCMSuffix(key.cm)));
+	}
+
 	tstring getVfrTmpFilePath(EncodeFileKey key) const {
 		return regtmp(StringFormat(_T("%s/t%d-%d-%d%s.%s"),
 			tmpDir.path(), key.video, key.format, key.div, GetCMSuffix(key.cm), getOutputExtention()));
@@ -119,6 +119,10 @@ public:
 		, adtsParser(ctx)
 	{ }
 
+	void setDeferDecode(bool defer) {
+		adtsParser.setDeferDecode(defer);
+	}
+
 	virtual void onPesPacket(int64_t clock, PESPacket packet) {
 		if (clock == -1) {
 			ctx.error("Audio PES Packet ɃNbN񂪂܂");
@@ -415,6 +419,7 @@ public:
 		, enableCaption(enableCaption)
 		, numTotalPackets(0)
 		, numScramblePackets(0)
+		, deferAudioDecode(false)
 	{
 		tsPacketParser.setHandler(&tsPacketHandler);
 		tsPacketParser.setNumBufferingPackets(50 * 1024); // 9.6MB
@@ -453,6 +458,15 @@ public:
 		return numScramblePackets;
 	}
 
+	// fR[hɏo͂łt[̓fR[hȂ
+	// iAudioFrameData::decodeDeferred̃t[͎ŃfR[h邱Ɓj
+	void setDeferAudioDecode(bool defer) {
+		deferAudioDecode = defer;
+		for (auto parser : audioParsers) {
+			parser->setDeferDecode(defer);
+		}
+	}
+
 protected:
 	enum INITIALIZATION_PHASE {
 		PMT_WAITING,	// PAT,PMT҂
@@ -571,6 +585,8 @@ protected:
 	int64_t numTotalPackets;
 	int64_t numScramblePackets;
 
+	bool deferAudioDecode;
+
 	virtual void onVideoPesPacket(
 		int64_t clock,
 		const std::vector<VideoFrameInfo>& frames,
@@ -651,6 +667,7 @@ protected:
 			while (audioParsers.size() < numAudios) {
 				int audioIdx = int(audioParsers.size());
 				audioParsers.push_back(new SpAudioFrameParser(ctx, *this, audioIdx));
+				audioParsers.back()->setDeferDecode(deferAudioDecode);
 				ctx.infoF("p[T %d ǉ", audioIdx);
 			}
 		}
@@ -479,6 +479,94 @@ TEST_F(TestBase, DecodePerformance)
 	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
 }
 
+TEST(Util, TsPacketParserPerf)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_tsparser_perf" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, TsPacketParserStride)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_tsparser" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, LogoKernel)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_logo_kernel" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, LogoFrameFilterPerf)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_logoframe_filter_perf" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, DataPumpPerf)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_datapump_perf" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST_F(TestBase, H264ParserPerf)
+{
+	std::wstring srcDir = TestDataDir + L"\\";
+
+	std::wstring srcfile = srcDir + H264VideoTsFile + L".ts";
+
+	const wchar_t* args[] = {
+		L"AmatsukazeTest.exe", L"--mode", L"test_h264parser_perf",
+		L"-i", srcfile.c_str(),
+	};
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, BitrateZonesPerf)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_zone_perf" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, LogoAnalyzePerf)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_logo_analyze_perf" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, ScratchArena)
+{
+	const wchar_t* args[] = { L"AmatsukazeTest.exe", L"--mode", L"test_scratch_arena" };
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, LogoAnalysisFile)
+{
+	const wchar_t* args[] = {
+		L"AmatsukazeTest.exe", L"--mode", L"test_logo_analysis_file",
+		L"-i", L"logo_analysis.dat",
+	};
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, LogoScanFrameStore)
+{
+	const wchar_t* args[] = {
+		L"AmatsukazeTest.exe", L"--mode", L"test_logo_scan_frames",
+		L"-i", L"logo_scan_frames.dat",
+	};
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
+TEST(Util, FilterEncodeMulti)
+{
+	const wchar_t* args[] = {
+		L"AmatsukazeTest.exe", L"--mode", L"test_filter_encode_multi",
+		L"-i", L"filter_encode_multi", L"-e", L"x264.exe",
+	};
+	EXPECT_EQ(AmatsukazeCLI(LEN(args), args), 0);
+}
+
 TEST_F(TestBase, VfrZonesBug)
 {
 	std::wstring srcfile = L"zone_param.dat";